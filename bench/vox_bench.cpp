@@ -0,0 +1,175 @@
+// Native microbenchmark for the VOX prosody encoder (src/vox_parser.cpp).
+// Builds without Windows headers:  make -f Makefile.bench run
+//
+// Feeds every line of a UTF-8 corpus through vox_process() and reports, per encoder stage,
+// time per input char, share of the total, heap allocations per call and (from the encoder's
+// built-in counters) how much the stage grows its text.
+//
+//   vox_bench [corpus.txt] [--iters N] [--clean]
+//   vox_bench [corpus.txt] [--clean] --emit     # print the encoded lines instead (golden check)
+
+#include "../src/vox_parser.hpp"
+#include "../src/vox_stages.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <string>
+#include <vector>
+
+// ---- allocation counter ----
+static unsigned long long g_allocs = 0;
+
+void* operator new(size_t n){
+    ++g_allocs;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t n){ return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+typedef std::chrono::steady_clock Clock;
+static inline unsigned long long now_ns(){
+    return (unsigned long long)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now().time_since_epoch()).count();
+}
+
+// ---- per-stage accumulators, fed by the encoder's stage hook ----
+struct StageAcc {
+    unsigned long long ns     = 0;
+    unsigned long long allocs = 0;
+    unsigned long long calls  = 0;
+    unsigned long long t0     = 0;
+    unsigned long long a0     = 0;
+};
+static StageAcc g_stage[VOX_STAGE_COUNT];
+
+static void on_stage(void*, int st, bool end){
+    StageAcc& s = g_stage[st];
+    if (!end){ s.a0 = g_allocs; s.t0 = now_ns(); return; }
+    unsigned long long t = now_ns();
+    s.ns     += t - s.t0;
+    s.allocs += g_allocs - s.a0;
+    ++s.calls;
+}
+
+// Minimal UTF-8 decoder (the app's u8_to_w lives in util.cpp, which needs windows.h).
+static std::wstring utf8_to_w(const std::string& s){
+    std::wstring w; w.reserve(s.size());
+    size_t i = 0;
+    while (i < s.size()){
+        unsigned char c = (unsigned char)s[i];
+        unsigned cp; size_t n;
+        if      (c < 0x80)          { cp = c;        n = 1; }
+        else if ((c >> 5) == 0x6)   { cp = c & 0x1F; n = 2; }
+        else if ((c >> 4) == 0xE)   { cp = c & 0x0F; n = 3; }
+        else if ((c >> 3) == 0x1E)  { cp = c & 0x07; n = 4; }
+        else                        { w.push_back(0xFFFD); ++i; continue; }
+        if (i + n > s.size()){ w.push_back(0xFFFD); break; }
+        for (size_t k = 1; k < n; ++k) cp = (cp << 6) | ((unsigned char)s[i+k] & 0x3F);
+        if (sizeof(wchar_t) == 2 && cp > 0xFFFF){
+            cp -= 0x10000;
+            w.push_back((wchar_t)(0xD800 + (cp >> 10)));
+            w.push_back((wchar_t)(0xDC00 + (cp & 0x3FF)));
+        } else {
+            w.push_back((wchar_t)cp);
+        }
+        i += n;
+    }
+    return w;
+}
+
+static std::string w_to_utf8(const std::wstring& w){
+    std::string s; s.reserve(w.size());
+    for (size_t i = 0; i < w.size(); ++i){
+        unsigned cp = (unsigned)w[i];
+        if (sizeof(wchar_t) == 2 && cp >= 0xD800 && cp < 0xDC00 && i+1 < w.size())
+            cp = 0x10000 + ((cp - 0xD800) << 10) + ((unsigned)w[++i] - 0xDC00);
+        if      (cp < 0x80)    s += (char)cp;
+        else if (cp < 0x800)   { s += (char)(0xC0 | (cp >> 6));  s += (char)(0x80 | (cp & 0x3F)); }
+        else if (cp < 0x10000) { s += (char)(0xE0 | (cp >> 12)); s += (char)(0x80 | ((cp >> 6) & 0x3F)); s += (char)(0x80 | (cp & 0x3F)); }
+        else { s += (char)(0xF0 | (cp >> 18)); s += (char)(0x80 | ((cp >> 12) & 0x3F)); s += (char)(0x80 | ((cp >> 6) & 0x3F)); s += (char)(0x80 | (cp & 0x3F)); }
+    }
+    return s;
+}
+
+int main(int argc, char** argv){
+    const char* path = "bench/corpus.txt";
+    int  iters = 200;
+    bool wrap  = true;
+    bool emit  = false;
+    for (int i = 1; i < argc; ++i){
+        if      (!std::strcmp(argv[i], "--iters") && i+1 < argc) iters = std::max(1, std::atoi(argv[++i]));
+        else if (!std::strcmp(argv[i], "--clean")) wrap = false;
+        else if (!std::strcmp(argv[i], "--emit")) emit = true;
+        else path = argv[i];
+    }
+
+    std::ifstream f(path);
+    if (!f){ std::fprintf(stderr, "vox_bench: cannot open %s\n", path); return 1; }
+    std::vector<std::wstring> lines;
+    size_t chars = 0;
+    for (std::string line; std::getline(f, line); ){
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        lines.push_back(utf8_to_w(line));
+        chars += lines.back().size();
+    }
+    if (lines.empty()){ std::fprintf(stderr, "vox_bench: %s is empty\n", path); return 1; }
+
+    // one output line per input line, no timing: what `make -f Makefile.bench check` diffs
+    if (emit){
+        for (const auto& l : lines) std::printf("%s\n", w_to_utf8(vox_process(l, wrap)).c_str());
+        return 0;
+    }
+
+    // warm-up (first-touch of the encoder's scratch buffers is not steady state)
+    for (const auto& l : lines) (void)vox_process(l, wrap);
+
+    // plain run: end-to-end numbers without the hook
+    unsigned long long a0 = g_allocs, t0 = now_ns();
+    size_t out_chars = 0;
+    for (int it = 0; it < iters; ++it)
+        for (const auto& l : lines) out_chars += vox_process(l, wrap).size();
+    unsigned long long total_ns = now_ns() - t0, total_allocs = g_allocs - a0;
+
+    // staged run: same work with the stage hook installed
+    vox_stage_stats_reset();
+    vox_set_stage_hook(on_stage, nullptr);
+    for (int it = 0; it < iters; ++it)
+        for (const auto& l : lines) (void)vox_process(l, wrap);
+    vox_set_stage_hook(nullptr, nullptr);
+
+    const double calls     = (double)iters * lines.size();
+    const double all_chars = (double)iters * chars;
+    const double sentences = (double)g_stage[VOX_STAGE_TOKENIZE].calls;
+    unsigned long long staged_ns = 0;
+    for (const auto& s : g_stage) staged_ns += s.ns;
+
+    std::printf("corpus      %s: %zu lines, %zu chars, %.0f sentences/pass, %d passes%s\n",
+                path, lines.size(), chars, sentences / iters, iters, wrap ? "" : " (clean)");
+    std::printf("total       %8.2f ns/char  %10.0f sentences/s  %10.0f calls/s  %6.2f allocs/call\n",
+                total_ns / all_chars, sentences / (total_ns * 1e-9), calls / (total_ns * 1e-9),
+                total_allocs / calls);
+    VoxStageStats built[VOX_STAGE_COUNT];
+    const bool have_built = vox_stage_stats(built);
+    std::printf("\n%-26s %10s %8s %14s %12s %8s\n", "stage", "ns/char", "share", "sentences/s", "allocs/call", "growth");
+    for (int st = 0; st < VOX_STAGE_COUNT; ++st){
+        const StageAcc& s = g_stage[st];
+        if (!s.calls) continue;
+        std::printf("%-26s %10.2f %7.1f%% %14.0f %12.2f", vox_stage_name(st),
+                    s.ns / all_chars, staged_ns ? 100.0 * s.ns / staged_ns : 0.0,
+                    s.ns ? sentences / (s.ns * 1e-9) : 0.0, s.allocs / calls);
+        if (have_built && built[st].units_in)
+            std::printf(" %8.3f", (double)built[st].units_out / built[st].units_in);
+        std::printf("\n");
+    }
+    std::printf("\n(output: %.1f chars per input char)\n", out_chars / all_chars);
+    return 0;
+}
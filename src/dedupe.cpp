@@ -0,0 +1,147 @@
+#include "dedupe.hpp"
+#include <unordered_map>
+#include <algorithm>
+
+namespace {
+
+constexpr uint32_t kBucketsPerWindow = 8;
+constexpr uint32_t kMinBucketMs      = 50;
+
+// What a line is compared by: the map key plus a second, independent hash and the length of
+// the normalized form, so two different lines that share a 64-bit key are not taken as copies.
+struct LineId {
+    uint64_t key   = 0;      // 0 = nothing left to compare
+    uint32_t check = 0;
+    uint32_t len   = 0;
+};
+
+struct Entry {
+    uint64_t    bucket;      // time bucket of the first copy
+    uint32_t    count;       // copies dropped since
+    uint32_t    check, len;  // LineId of the first copy
+    std::string text;        // first copy (keep_text only)
+};
+
+struct State {
+    uint32_t window = 0, width = 1, span = 1;   // span: buckets per window
+    bool     keep_text = false;
+    uint64_t tail = 0;                           // oldest bucket that may still hold keys
+    bool     started = false;
+    uint32_t last_ms = 0;                        // tick count of the previous call
+    uint64_t elapsed_ms = 0;                     // since the first call: buckets survive the tick wrap
+    std::unordered_map<uint64_t, Entry> map;
+    std::vector<std::vector<uint64_t>>  ring;    // span + 1 slots, keys by first-seen bucket
+    std::vector<DedupeRepeat> pending;           // repeats expired inside dedupe_check()
+    DedupeStats stats;
+};
+State g;
+
+// FNV-1a (the key) and a multiply-rotate hash (the check) over the normalized bytes
+LineId line_id(const std::string& s){
+    LineId id;
+    uint64_t h = 1469598103934665603ull;
+    uint32_t m = 0x9E3779B9u;
+    for (unsigned char c : s){
+        if (c < 0x80){
+            if (c >= 'A' && c <= 'Z') c = (unsigned char)(c - 'A' + 'a');
+            else if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))) continue;
+        }
+        h = (h ^ c) * 1099511628211ull;
+        m = ((m + c) * 0x85EBCA6Bu);
+        m = (m << 13) | (m >> 19);
+        ++id.len;
+    }
+    if (id.len){ id.key = h ? h : 1; id.check = m; }
+    return id;
+}
+
+// Bucket of `now_ms` (a GetTickCount() value): the time is summed from tick deltas, so it keeps
+// counting when the 32-bit tick wraps after 49.7 days
+uint64_t bucket_of(uint32_t now_ms){
+    if (!g.started){ g.last_ms = now_ms; g.elapsed_ms = 0; }
+    else if ((int32_t)(now_ms - g.last_ms) > 0){
+        g.elapsed_ms += (uint32_t)(now_ms - g.last_ms);
+        g.last_ms = now_ms;
+    }
+    return g.elapsed_ms / g.width;
+}
+
+void sweep(uint64_t bucket, std::vector<DedupeRepeat>& out){
+    std::vector<uint64_t>& slot = g.ring[bucket % g.ring.size()];
+    for (uint64_t k : slot){
+        auto it = g.map.find(k);
+        if (it == g.map.end() || it->second.bucket != bucket) continue;
+        if (g.keep_text && it->second.count){
+            out.push_back(DedupeRepeat{ std::move(it->second.text), it->second.count });
+            ++g.stats.repeats;
+        }
+        g.map.erase(it);
+    }
+    slot.clear();
+}
+
+// Returns the current bucket
+uint64_t expire(uint32_t now_ms, std::vector<DedupeRepeat>& out){
+    const uint64_t cur = bucket_of(now_ms);
+    if (!g.started){ g.tail = cur; g.started = true; return cur; }
+    // a bucket goes once all of it is older than the window; after a long idle gap every
+    // slot has been swept once and the rest of the gap is empty
+    for (size_t steps = 0; cur - g.tail >= g.span && steps < g.ring.size(); ++steps)
+        sweep(g.tail++, out);
+    if (cur - g.tail >= g.span) g.tail = cur - g.span + 1;
+    return cur;
+}
+
+} // namespace
+
+void dedupe_configure(uint32_t window_ms, bool keep_text){
+    g = State{};
+    g.window = window_ms;
+    g.keep_text = keep_text;
+    if (!window_ms) return;
+    g.width = std::max(kMinBucketMs, window_ms / kBucketsPerWindow);
+    g.span  = (window_ms + g.width - 1) / g.width;
+    g.ring.resize(g.span + 1);
+}
+
+bool dedupe_enabled(){ return g.window != 0; }
+
+bool dedupe_check(const std::string& line, uint32_t now_ms){
+    if (!g.window) return true;
+    ++g.stats.seen;
+    const LineId id = line_id(line);
+    if (!id.key) return true;
+    const uint64_t cur = expire(now_ms, g.pending);
+    auto r = g.map.emplace(id.key, Entry{});
+    if (!r.second){
+        Entry& e = r.first->second;
+        if (e.check != id.check || e.len != id.len){   // a different line with the same key: speak it
+            ++g.stats.collisions;
+            return true;
+        }
+        ++e.count;
+        ++g.stats.dropped;
+        return false;
+    }
+    Entry& e = r.first->second;
+    e.bucket = cur;
+    e.count  = 0;
+    e.check  = id.check;
+    e.len    = id.len;
+    if (g.keep_text) e.text = line;
+    g.ring[e.bucket % g.ring.size()].push_back(id.key);
+    return true;
+}
+
+void dedupe_expire(uint32_t now_ms, std::vector<DedupeRepeat>& repeats){
+    if (!g.window) return;
+    expire(now_ms, g.pending);
+    for (DedupeRepeat& r : g.pending) repeats.push_back(std::move(r));
+    g.pending.clear();
+}
+
+DedupeStats dedupe_stats(){
+    DedupeStats s = g.stats;
+    s.live = g.map.size();
+    return s;
+}
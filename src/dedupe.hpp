@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Drops chat lines already seen within a time window (raids, bot loops). A line is keyed by a
+// 64-bit hash of its normalized form: ASCII folded to lowercase, punctuation and whitespace
+// ignored, other UTF-8 bytes kept ("GG!!", "gg" and "g g" are one line). Keys live in a hash
+// map and in a ring of time buckets (1/8 of the window each), so a check is O(1) and expiry
+// only visits the keys of buckets that fell out of the window. A second hash and the length
+// are compared too: a key collision lets the new line through instead of dropping it.
+// UI thread only.
+struct DedupeRepeat {
+    std::string text;        // the first copy, as it was checked
+    uint32_t    count;       // copies dropped after it
+};
+
+struct DedupeStats {
+    uint64_t seen     = 0;
+    uint64_t dropped  = 0;
+    uint64_t repeats  = 0;   // DedupeRepeat summaries handed out
+    uint64_t collisions = 0; // different lines that shared a key (spoken, not dropped)
+    size_t   live     = 0;   // keys in the window
+};
+
+// window_ms 0 = off (every line passes). keep_text: remember first copies so dedupe_expire()
+// can report how often each was repeated.
+void dedupe_configure(uint32_t window_ms, bool keep_text);
+bool dedupe_enabled();
+
+// true: first copy in the window, speak it; false: a duplicate (counted, dropped)
+bool dedupe_check(const std::string& line, uint32_t now_ms);
+
+// Forgets keys older than the window; with keep_text, appends the ones that were repeated.
+void dedupe_expire(uint32_t now_ms, std::vector<DedupeRepeat>& repeats);
+
+DedupeStats dedupe_stats();
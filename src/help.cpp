@@ -49,6 +49,14 @@ std::wstring get_help_text_w(){ // central source of truth
         L"                       [--host HOST] [--port N] [--devnum N]",
         L"                       [--vox | --voxclean] [--posn-ms N] [--selftest]",
         L"                       [--status-port N] [--log C:\\path\\file.log]",
+        L"                       [--vox-cache N] [--vox-batch IN OUT [--vox-batch-threads N]]",
+        L"                       [--rulepack FILE.ntrp]... [--compile-rulepack SRC OUT]",
+        L"                       [--lexicon FILE] [--templates FILE]",
+        L"                       [--max-msg-seconds S] [--max-queue-seconds S] [--nosanitize]",
+        L"                       [--lane-port LANE=PORT]... [--coalesce-chars N] [--coalesce-seconds S]",
+        L"                       [--submit-window N] [--queue-max-chunks N] [--queue-max-kb N]",
+        L"                       [--queue-policy newest|oldest|lowest] [--dedupe-seconds S [--dedupe-count]]",
+        L"                       [--ttl LANE=S]... [--weight SOURCE=W]...",
         L"",
         L"Options:",
         L"  --startserver        Start the TCP server (GUI stays visible; no console window)",
@@ -57,10 +65,36 @@ std::wstring get_help_text_w(){ // central source of truth
         L"  --host HOST          TCP host to bind (default 127.0.0.1)",
         L"  --port N             TCP port (default 5555)",
         L"  --status-port N      Status server TCP port (default --port+1)",
+        L"  --lane-port LANE=PORT  Extra command port whose lines go to queue lane alert|announce|chat",
+        L"                       (repeatable; the main --port feeds the chat lane)",
+        L"  --ttl LANE=S         Drop messages of that lane still unspoken after S seconds (repeatable)",
+        L"  --weight SOURCE=W    Share of a lane for source SOURCE relative to others (default 1; repeatable)",
         L"  --list-devices        Print output device indices and names, then exit",
         L"  --devnum N           Output device number (-1 = default mapper)",
         L"  --vox                Enable VOX prosody (adds vendor tags; wraps with \\!wH1..\\!wH0)",
         L"  --voxclean           VOX prosody without wH wrap (no \\!wH1/\\!wH0; still adds \\!br, etc.)",
+        L"  --vox-cache N        Remember the VOX output of the last N distinct lines (default 256, 0 = off)",
+        L"  --vox-batch IN OUT   Write the VOX form of every line of UTF-8 file IN to OUT, then exit",
+        L"                       (uses all CPUs; add --voxclean for output without the \\!wH1/\\!wH0 wrap)",
+        L"  --vox-batch-threads N  Worker threads for --vox-batch (default 0 = one per CPU)",
+        L"  --rulepack PATH      Load a compiled VOX rule pack (repeatable; the first one is the default)",
+        L"  --compile-rulepack SRC OUT  Compile a rule-pack source file to OUT (.ntrp), then exit",
+        L"  --lexicon PATH       Rewrite words and phrases from a \"word = replacement\" file before speaking",
+        L"  --templates PATH     Load \"name = text with {slot}\" announcement templates (see /tmpl)",
+        L"  --max-msg-seconds S  Cut any one message after about S seconds of speech (0 = no cap)",
+        L"  --max-queue-seconds S  Cap the speech queue at about S seconds (0 = no cap)",
+        L"  --coalesce-chars N   Merge queued chunks of one message into TextData calls of up to N chars",
+        L"                       (default 1000; 0 = one call per chunk)",
+        L"  --coalesce-seconds S Cap a merged call at about S seconds of speech (default 6)",
+        L"  --submit-window N    Utterances handed to the engine ahead of playback (1..8, default 2)",
+        L"  --queue-max-chunks N Cap the speech queue at N chunks (0 = no cap)",
+        L"  --queue-max-kb N     Cap the speech queue at N KB of text (0 = no cap)",
+        L"  --queue-policy P     When full, drop from the source most over its share: newest = its newest",
+        L"                       message (default), oldest = its oldest, lowest = its lowest-lane one",
+        L"  --nosanitize         Speak chat text as-is (default: URLs -> \"link\", emoji dropped, \"!!!!\" -> \"!\")",
+        L"  --dedupe-seconds S   Drop a chat line seen again within S seconds (case, spaces and punctuation",
+        L"                       ignored; 0 = off)",
+        L"  --dedupe-count       After the window, say \"Repeated N more times: ...\" for dropped copies",
         L"  --posn-ms N          Enable periodic PosnGet polling every N milliseconds (if the engine supports it)",
         L"  --selftest           Queue a short audible self-test matrix and speak it",
         L"  --log PATH           Also write logs to PATH (append mode not implemented)",
@@ -79,10 +113,23 @@ std::wstring get_help_text_w(){ // central source of truth
         L"  /pitch N             Set pitch (0..200, 100=1.00)",
         L"  /pause ms            Insert a pause tag (e.g. 500 -> \\!sf500) and boundary",
         L"  /stop                Stop current speech",
+        L"  /stats               Log counters and send them as STAT lines on the status socket",
+        L"  /stats reset         Zero the per-stage VOX encoder counters",
+        L"  /pack NAME           Make rule pack NAME the default (\"builtin\" = compiled-in rules)",
+        L"  /pack load PATH      Load or hot-swap a compiled rule pack",
+        L"  /lexicon reload      Re-read the --lexicon file (/lexicon load PATH switches files)",
+        L"  /tmpl NAME k=v ...   Speak template NAME with its {k} slots filled (/tmpl reload re-reads)",
+        L"  /ttl LANE S          Set a lane's time-to-live (0 = none); /ttl alone reports the lanes",
+        L"  /source NAME         Name this connection's source (default client-N); /source alone reports",
+        L"  /source weight NAME W  Set a source's weight",
         L"  /quit | /exit        Shutdown the server/app",
         L"",
         L"Inline markup:",
         L"  [[pause 500]]        In-band pause directive (transforms to \\!sf500 plus \\!br)",
+        L"  [[pack NAME]] text   At the start of a line: use rule pack NAME for this message",
+        L"  [[lane NAME]] text   At the start of a line (before [[pack]] or a /tmpl): queue in lane NAME",
+        L"                       (alert before announce before chat)",
+        L"  [[ttl S]] text       After any [[lane]]: drop this message if still unspoken after S seconds",
         L"",
         L"Notes:",
         L"  * In VOX modes, final cadence adds a ~500ms pause and a boundary.",
@@ -0,0 +1,106 @@
+#include "ingress.hpp"
+#include "ipc.hpp"
+#include <atomic>
+#include <algorithm>
+
+namespace {
+
+constexpr uint32_t kSlots    = 1024;              // power of two
+constexpr uint32_t kMask     = kSlots - 1;
+constexpr size_t   kKeepCap  = 64 * 1024;         // a slot that held a bigger line gives it back
+
+// Bounded MPMC-style ring (per-slot sequence numbers): a producer owns slot `pos` once
+// seq == pos, publishes it with seq = pos + 1; the consumer frees it with seq = pos + kSlots.
+struct Slot {
+    std::atomic<uint32_t> seq{0};
+    int                   tag = 0;
+    uint32_t              source = 0;
+    std::string           line;
+};
+
+struct Ring {
+    Slot                  slots[kSlots];
+    std::atomic<uint32_t> head{0};                // next position producers claim
+    std::atomic<uint32_t> tail{0};                // next position the consumer reads (producers only peek for high_water)
+    std::atomic<bool>     wake{false};            // a WM_APP_INGRESS is on its way
+    std::atomic<HWND>     hwnd{nullptr};
+    std::atomic<uint64_t> lines{0}, wakeups{0}, full{0};
+    std::atomic<uint32_t> high_water{0};
+    Ring(){ for (uint32_t i = 0; i < kSlots; ++i) slots[i].seq.store(i, std::memory_order_relaxed); }
+};
+Ring g_ring;
+
+// Posts WM_APP_INGRESS unless one is already on its way
+void wake_consumer(){
+    if (g_ring.wake.exchange(true, std::memory_order_acq_rel)) return;
+    HWND h = g_ring.hwnd.load(std::memory_order_acquire);
+    if (h && PostMessageW(h, WM_APP_INGRESS, 0, 0)) g_ring.wakeups.fetch_add(1, std::memory_order_relaxed);
+    else g_ring.wake.store(false, std::memory_order_release);   // let the next push try again
+}
+
+} // namespace
+
+void ingress_set_target(HWND hwnd){
+    g_ring.hwnd.store(hwnd, std::memory_order_release);
+}
+
+bool ingress_push(const char* data, size_t len, int tag, uint32_t source, bool retry){
+    uint32_t pos = g_ring.head.load(std::memory_order_relaxed);
+    Slot* s;
+    for (;;){
+        s = &g_ring.slots[pos & kMask];
+        const int32_t d = (int32_t)(s->seq.load(std::memory_order_acquire) - pos);
+        if (d == 0){
+            if (g_ring.head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (d < 0){
+            if (!retry) g_ring.full.fetch_add(1, std::memory_order_relaxed);
+            wake_consumer();   // a failed post must not leave a full ring with nobody draining it
+            return false;
+        } else {
+            pos = g_ring.head.load(std::memory_order_relaxed);
+        }
+    }
+    s->line.assign(data, len);
+    s->tag = tag;
+    s->source = source;
+    s->seq.store(pos + 1, std::memory_order_release);
+
+    g_ring.lines.fetch_add(1, std::memory_order_relaxed);
+    // a racy estimate: the consumer may already be past this slot, or its tail may read stale
+    const int32_t depth = std::min((int32_t)(pos + 1 - g_ring.tail.load(std::memory_order_relaxed)), (int32_t)kSlots);
+    uint32_t hw = g_ring.high_water.load(std::memory_order_relaxed);
+    while (depth > (int32_t)hw && !g_ring.high_water.compare_exchange_weak(hw, (uint32_t)depth, std::memory_order_relaxed)) {}
+
+    wake_consumer();
+    return true;
+}
+
+void ingress_begin_drain(){
+    // cleared before reading: anything published after this posts a fresh wakeup. An RMW, not
+    // a store: a producer that still finds the flag set synchronizes with this clear, so its
+    // slot is visible to the pops that follow (a plain store could sink below them).
+    g_ring.wake.exchange(false, std::memory_order_acq_rel);
+}
+
+bool ingress_pop(std::string& line, int& tag, uint32_t& source){
+    const uint32_t pos = g_ring.tail.load(std::memory_order_relaxed);
+    Slot& s = g_ring.slots[pos & kMask];
+    if (s.seq.load(std::memory_order_acquire) != pos + 1) return false;
+    line.assign(s.line);
+    tag = s.tag;
+    source = s.source;
+    if (s.line.capacity() > kKeepCap) std::string().swap(s.line);
+    s.seq.store(pos + kSlots, std::memory_order_release);
+    g_ring.tail.store(pos + 1, std::memory_order_relaxed);
+    return true;
+}
+
+IngressStats ingress_stats(){
+    IngressStats st;
+    st.lines      = g_ring.lines.load(std::memory_order_relaxed);
+    st.wakeups    = g_ring.wakeups.load(std::memory_order_relaxed);
+    st.full       = g_ring.full.load(std::memory_order_relaxed);
+    st.capacity   = kSlots;
+    st.high_water = g_ring.high_water.load(std::memory_order_relaxed);
+    return st;
+}
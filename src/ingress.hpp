@@ -0,0 +1,31 @@
+#pragma once
+#include <windows.h>
+#include <cstdint>
+#include <string>
+
+// Command lines from the network thread to the UI thread: a bounded lock-free
+// multi-producer / single-consumer ring of pooled line buffers. Each slot keeps its
+// string's capacity, so a warm ring copies lines without allocating. Producers post one
+// WM_APP_INGRESS per batch: only the first push after the consumer started draining wakes it.
+struct IngressStats {
+    uint64_t lines      = 0;
+    uint64_t wakeups    = 0;   // WM_APP_INGRESS posted
+    uint64_t full       = 0;   // lines that found the ring full (retries not counted again)
+    uint32_t capacity   = 0;
+    uint32_t high_water = 0;   // deepest the ring has been
+};
+
+void ingress_set_target(HWND hwnd);   // window that gets WM_APP_INGRESS
+
+// Producer side (any thread). `tag` and `source` travel with the line (the listen port's lane
+// tag, the connection id; tag -1 with an empty line: that connection closed).
+// false = the ring is full and the line was not taken; retry after the consumer catches up,
+// with `retry` set so the line is not counted as refused twice.
+bool ingress_push(const char* data, size_t len, int tag, uint32_t source, bool retry = false);
+
+// Consumer side (UI thread only): on WM_APP_INGRESS call ingress_begin_drain(), then
+// ingress_pop() until it returns false (or stop early and post yourself another wakeup).
+void ingress_begin_drain();
+bool ingress_pop(std::string& line, int& tag, uint32_t& source);
+
+IngressStats ingress_stats();
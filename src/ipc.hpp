@@ -4,7 +4,7 @@
 
 // ---- Existing app messages (these guards let your old values stand) ----
 #ifndef WM_APP_SPEAK
-#define WM_APP_SPEAK        (WM_APP + 1)   // payload: std::string* (UTF-8)
+#define WM_APP_SPEAK        (WM_APP + 1)   // payload: std::string* (UTF-8); wParam: lane + 1 (0 = chat)
 #endif
 
 // If you already have START/DONE etc., leave them where they are.
@@ -70,6 +70,10 @@
 #define WM_APP_SET_TEXT     (WM_APP + 24)    // main → GUI: payload std::string*
 #endif
 
+#ifndef WM_APP_INGRESS
+#define WM_APP_INGRESS      (WM_APP + 25)    // net → main: lines waiting in the ingress ring (ingress.hpp)
+#endif
+
 // ---- POD payloads ----
 struct GuiAttrs { int vol_percent; int rate_percent; int pitch_percent; };
 struct GuiDeviceSel { int index; /* -1 = default */ };
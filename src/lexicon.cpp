@@ -0,0 +1,231 @@
+#include "lexicon.hpp"
+#include "util.hpp"
+#include <windows.h>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cctype>
+
+struct Lexicon {
+    std::wstring path;
+    uint32_t width = 1;                  // byte classes + 1; class 0 = byte in no pattern
+    uint8_t  cls[256] = {};
+    std::vector<int32_t>  delta;         // state * width + class -> state (complete DFA)
+    std::vector<int32_t>  term;          // entry that ends exactly at this state, or -1
+    std::vector<int32_t>  dict;          // next state on the failure chain with term >= 0, or -1
+    std::vector<std::string> to;         // per entry
+    std::vector<uint32_t> len;           // pattern length in bytes
+    std::vector<uint8_t>  edge;          // EDGE_* bits
+};
+
+namespace {
+
+enum : uint8_t { EDGE_START = 1, EDGE_END = 2 };   // must sit on a word boundary
+
+// Cap on the transition table (states * classes); a lexicon this large is almost certainly
+// not a hand-written one.
+constexpr size_t kMaxCells = size_t(16) << 20;
+
+inline unsigned char fold(unsigned char c){ return (c >= 'A' && c <= 'Z') ? (unsigned char)(c | 0x20) : c; }
+// Non-ASCII bytes count as word bytes, so "café" isn't split inside the é.
+inline bool word_byte(unsigned char c){ return c >= 0x80 || c == '_' || isalnum(c); }
+
+struct Entry { std::string from, to; };
+
+bool parse_lexicon(const std::string& text, std::vector<Entry>& out, std::string& err){
+    size_t pos = 0, lineno = 0;
+    auto fail = [&](const char* what){
+        char buf[160]; snprintf(buf, sizeof(buf), "line %u: %s", (unsigned)lineno, what);
+        err = buf; return false;
+    };
+    auto trim = [](std::string& s){
+        while (!s.empty() && isspace((unsigned char)s.back())) s.pop_back();
+        size_t b = 0; while (b < s.size() && isspace((unsigned char)s[b])) ++b;
+        s.erase(0, b);
+    };
+    while (pos < text.size()){
+        size_t nl = text.find('\n', pos);
+        std::string line = text.substr(pos, nl == std::string::npos ? std::string::npos : nl - pos);
+        pos = (nl == std::string::npos) ? text.size() : nl + 1;
+        ++lineno;
+        trim(line);
+        // Only whole-line comments: "#" is a legitimate part of entries like "C# = C sharp".
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) return fail("expected word = replacement");
+        Entry e{ line.substr(0, eq), line.substr(eq + 1) };
+        trim(e.from); trim(e.to);
+        if (e.from.empty()) return fail("empty word");
+        for (char& c : e.from) c = (char)fold((unsigned char)c);
+        out.push_back(std::move(e));
+    }
+    return true;
+}
+
+bool build(const std::vector<Entry>& entries, Lexicon& lx, std::string& err){
+    // Byte classes: every byte that occurs in some pattern gets its own class, the rest
+    // share class 0 (which always leads back to the root).
+    uint32_t ncls = 1;
+    for (const Entry& e : entries)
+        for (unsigned char c : e.from){
+            if (lx.cls[c]) continue;
+            lx.cls[c] = (uint8_t)ncls++;
+            if (c >= 'a' && c <= 'z') lx.cls[c & ~0x20] = lx.cls[c];
+        }
+    lx.width = ncls;
+    const uint32_t W = lx.width;
+
+    // Trie. Duplicate words keep the last replacement, so a later line overrides an earlier one.
+    lx.delta.assign(W, -1);
+    lx.term.assign(1, -1);
+    for (const Entry& e : entries){
+        int32_t s = 0;
+        for (unsigned char c : e.from){
+            int32_t& next = lx.delta[(size_t)s * W + lx.cls[c]];
+            if (next < 0){
+                if ((lx.term.size() + 1) * W > kMaxCells){ err = "lexicon too large"; return false; }
+                next = (int32_t)lx.term.size();
+                lx.term.push_back(-1);
+                lx.delta.resize(lx.delta.size() + W, -1);
+            }
+            s = lx.delta[(size_t)s * W + lx.cls[c]];
+        }
+        int32_t id = lx.term[s];
+        if (id < 0){
+            id = (int32_t)lx.to.size();
+            lx.term[s] = id;
+            lx.to.emplace_back();
+            lx.len.push_back((uint32_t)e.from.size());
+            uint8_t edge = 0;
+            if (word_byte((unsigned char)e.from.front())) edge |= EDGE_START;
+            if (word_byte((unsigned char)e.from.back()))  edge |= EDGE_END;
+            lx.edge.push_back(edge);
+        }
+        lx.to[id] = e.to;
+    }
+
+    // Failure links, folded into the transition table breadth-first so that matching is one
+    // lookup per byte.
+    const size_t S = lx.term.size();
+    std::vector<int32_t> fail(S, 0), queue;
+    queue.reserve(S);
+    lx.dict.assign(S, -1);
+    for (uint32_t c = 0; c < W; ++c){
+        int32_t& t = lx.delta[c];
+        if (t < 0) t = 0;
+        else queue.push_back(t);
+    }
+    for (size_t qi = 0; qi < queue.size(); ++qi){
+        const int32_t s = queue[qi];
+        const int32_t f = fail[s];
+        lx.dict[s] = lx.term[f] >= 0 ? f : lx.dict[f];
+        for (uint32_t c = 0; c < W; ++c){
+            int32_t& t = lx.delta[(size_t)s * W + c];
+            const int32_t via = lx.delta[(size_t)f * W + c];
+            if (t < 0) t = via;
+            else { fail[t] = via; queue.push_back(t); }
+        }
+    }
+    return true;
+}
+
+struct Match { uint32_t start, len; int32_t id; };
+
+std::wstring win_error(const wchar_t* what, const std::wstring& path){
+    wchar_t buf[64]; _snwprintf(buf, 63, L" (error %lu)", GetLastError()); buf[63] = 0;
+    return std::wstring(what) + L" " + path + buf;
+}
+
+LexiconRef g_current;
+
+} // namespace
+
+bool lexicon_compile(const std::wstring& path, LexiconRef& out, std::wstring& err){
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE){ err = win_error(L"cannot read", path); return false; }
+    std::string text;
+    char buf[16384]; DWORD rd = 0;
+    while (ReadFile(h, buf, sizeof(buf), &rd, nullptr) && rd > 0) text.append(buf, rd);
+    CloseHandle(h);
+    if (text.compare(0, 3, "\xEF\xBB\xBF") == 0) text.erase(0, 3);
+
+    std::vector<Entry> entries; std::string e;
+    auto lx = std::make_shared<Lexicon>();
+    lx->path = path;
+    if (!parse_lexicon(text, entries, e) || !build(entries, *lx, e)){
+        err = path + L": " + u8_to_w(e);
+        return false;
+    }
+    out = lx;
+    return true;
+}
+
+size_t lexicon_rewrite(const Lexicon& lx, std::string& text){
+    if (lx.to.empty() || text.empty()) return 0;
+    const unsigned char* p = (const unsigned char*)text.data();
+    const size_t n = text.size();
+    const int32_t* delta = lx.delta.data();
+    const uint32_t W = lx.width;
+
+    // Scan: collect every match whose word edges hold. Entries are words and short phrases,
+    // so a line has few candidates.
+    static thread_local std::vector<Match> cand;
+    cand.clear();
+    int32_t s = 0;
+    for (size_t i = 0; i < n; ++i){
+        s = delta[(size_t)s * W + lx.cls[p[i]]];
+        for (int32_t q = lx.term[s] >= 0 ? s : lx.dict[s]; q >= 0; q = lx.dict[q]){
+            const int32_t id = lx.term[q];
+            const size_t L = lx.len[id], start = i + 1 - L;
+            if ((lx.edge[id] & EDGE_START) && start > 0 && word_byte(p[start - 1])) continue;
+            if ((lx.edge[id] & EDGE_END) && i + 1 < n && word_byte(p[i + 1])) continue;
+            cand.push_back(Match{ (uint32_t)start, (uint32_t)L, id });
+        }
+    }
+    if (cand.empty()) return 0;
+
+    // Select: leftmost first, longest among equal starts, never overlapping.
+    std::sort(cand.begin(), cand.end(), [](const Match& a, const Match& b){
+        return a.start != b.start ? a.start < b.start : a.len > b.len;
+    });
+    std::string out;
+    out.reserve(n + n / 4);
+    size_t at = 0, count = 0;
+    for (const Match& m : cand){
+        if (m.start < at) continue;
+        out.append(text, at, m.start - at);
+        out += lx.to[m.id];
+        at = m.start + m.len;
+        ++count;
+    }
+    out.append(text, at, std::string::npos);
+    text.swap(out);
+    return count;
+}
+
+std::string lexicon_describe(const Lexicon& lx){
+    char buf[64];
+    snprintf(buf, sizeof(buf), "entries=%u states=%u path=", (unsigned)lx.to.size(), (unsigned)lx.term.size());
+    return buf + w_to_u8(lx.path);
+}
+
+bool lexicon_load(const std::wstring& path, std::wstring& err){
+    LexiconRef lx;
+    if (!lexicon_compile(path, lx, err)) return false;
+    std::atomic_store(&g_current, lx);
+    return true;
+}
+
+bool lexicon_reload(std::wstring& err){
+    LexiconRef cur = std::atomic_load(&g_current);
+    if (!cur){ err = L"no lexicon loaded"; return false; }
+    return lexicon_load(cur->path, err);
+}
+
+LexiconRef lexicon_current(){
+    return std::atomic_load(&g_current);
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <memory>
+#include <string>
+
+// User pronunciation lexicon: one "from = to" entry per line (UTF-8), e.g. "gg = good game".
+// Matching ignores ASCII case, and a pattern that starts (ends) with a letter or digit only
+// matches at the start (end) of a word. Overlaps go to the leftmost, then longest, entry.
+//
+// Entries are compiled into one Aho-Corasick automaton (a dense byte-class DFA), so rewriting
+// a line is one pass over its bytes whatever the number of entries.
+struct Lexicon;
+typedef std::shared_ptr<const Lexicon> LexiconRef;
+
+bool lexicon_compile(const std::wstring& path, LexiconRef& out, std::wstring& err);
+// Rewrites every match in place; returns the number of replacements.
+size_t lexicon_rewrite(const Lexicon& lx, std::string& text);
+// "entries=N states=M path=..."
+std::string lexicon_describe(const Lexicon& lx);
+
+// The active lexicon. Loading replaces it atomically; a message being rewritten keeps the
+// LexiconRef it started with.
+bool lexicon_load(const std::wstring& path, std::wstring& err);
+bool lexicon_reload(std::wstring& err);   // the active lexicon's file again
+LexiconRef lexicon_current();             // null when none is loaded
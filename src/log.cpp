@@ -17,6 +17,7 @@ void log_set_path(const std::wstring& path){
 
 void log_set_verbose(bool on){ g_verbose = on; }   // NEW
 bool log_has_console(){ return g_has_console; }
+bool log_is_enabled(){ return (g_has_console && g_verbose) || g_logFile; }
 
 void log_attach_console(){
     if(g_has_console) return;
@@ -7,4 +7,7 @@ void log_set_verbose(bool on);   // NEW
 void log_attach_console();
 void log_open_default_if_needed();
 bool log_has_console();
+// True when dprintf output goes anywhere but the debugger (verbose console or a log file);
+// callers use it to skip building log-only strings.
+bool log_is_enabled();
 void dprintf(const char* fmt, ...);
@@ -4,6 +4,8 @@
 #include <shellapi.h>
 #include <string>
 #include <deque>
+#include <map>
+#include <vector>
 #include <utility>
 #include <algorithm>
 #include <cctype>
@@ -11,6 +13,16 @@
 #include <cstdlib>
 #include "log.hpp"
 #include "vox_parser.hpp"
+#include "vox_cache.hpp"
+#include "vox_batch.hpp"
+#include "vox_rulepack.hpp"
+#include "vox_stages.hpp"
+#include "lexicon.hpp"
+#include "templates.hpp"
+#include "speech_time.hpp"
+#include "sanitize.hpp"
+#include "dedupe.hpp"
+#include "ingress.hpp"
 #include "tts_engine.hpp"
 
 #include "net_server.hpp"
@@ -48,34 +60,398 @@ static LONG         g_inflight_local= 0;
 
 static bool g_vox_enabled = false;
 static bool g_vox_clean   = false; 
+static int  g_vox_cache_entries = 256;        // --vox-cache N (0 = off)
+static std::wstring g_vox_batch_in, g_vox_batch_out;   // --vox-batch IN OUT (transform, then exit)
+static int  g_vox_batch_threads = 0;          // --vox-batch-threads N (0 = one per CPU)
+static std::vector<std::wstring> g_rulepacks;  // --rulepack PATH (repeatable; first = default)
+static std::wstring g_compile_src, g_compile_out;   // --compile-rulepack SRC OUT (then exit)
+static std::wstring g_lexicon_path;           // --lexicon PATH
+static std::wstring g_templates_path;         // --templates PATH
+static double g_max_msg_ms   = 0;             // --max-msg-seconds S (0 = no cap)
+static double g_max_queue_ms = 0;             // --max-queue-seconds S (0 = no cap)
+static bool   g_sanitize     = true;          // --nosanitize turns the chat clean-up off
+static SanitizeStats g_sanitize_stats;
+static double g_dedupe_ms    = 0;             // --dedupe-seconds S (0 = off)
+static bool   g_dedupe_count = false;         // --dedupe-count: say how often a dropped line repeated
+static std::vector<ServerLanePort> g_lane_ports;   // --lane-port NAME=PORT (repeatable)
+static size_t g_coalesce_chars = 1000;        // --coalesce-chars N (0 = one chunk per TextData)
+static double g_coalesce_ms    = 6000;        // --coalesce-seconds S
+static int    g_submit_window  = 2;           // --submit-window N: utterances handed to the engine at once
+enum QueuePolicy { DROP_NEWEST, DROP_OLDEST, DROP_LOWEST };
+static const char* const kPolicyNames[] = { "newest", "oldest", "lowest" };
+static size_t      g_queue_max_chunks = 0;    // --queue-max-chunks N (0 = no cap)
+static size_t      g_queue_max_bytes  = 0;    // --queue-max-kb N (0 = no cap)
+static QueuePolicy g_queue_policy = DROP_NEWEST;   // --queue-policy newest|oldest|lowest
 
 static bool g_cli_help  = false;  // --help (print/show help then exit)
 
 // ------------------------------------------------------------------
-// Chunk queue
-struct Chunk { std::wstring text; };
-static std::deque<Chunk> g_q;
+// Chunk queue: one set of FIFOs per priority lane, highest first. kick_if_idle() always
+// serves the first non-empty lane, so an alert waits for at most the chunk already speaking,
+// however much chat is queued behind it.
+// Within a lane every source (connection) has its own FIFO, a flow, and the flows share the
+// lane by weighted deficit round robin: each turn adds kQuantumMs x the source's weight of
+// estimated speech to its deficit, and it speaks while the deficit covers its next chunk. A
+// busy bot gets its share of the lane instead of everything ahead of a viewer's line.
+struct Chunk { std::wstring text; SpeechCost cost; DWORD queued_at; uint32_t msg; DWORD expires; };   // msg 0: not part of a message; expires 0: never
+struct Flow {
+    std::string       source;
+    std::deque<Chunk> q;         // never empty: a drained flow leaves its lane
+    double            deficit = 0;   // ms of speech it may still start this round (negative: overspent)
+};
+struct Lane {
+    const char*       name;
+    std::vector<Flow> flows;     // in round-robin order
+    size_t   rr      = 0;        // flow whose turn it is
+    bool     turn    = false;    // flows[rr] got its quantum for this turn
+    uint32_t cur_msg = 0;        // message it started; finished before the turn moves on
+    size_t   depth   = 0;        // chunks over all flows
+    SpeechCost cost;             // of those chunks: queued_ms() without walking the flows
+    size_t   peak    = 0;        // deepest the lane has been
+    uint64_t served  = 0;        // chunks handed to the engine (before coalescing)
+    double   wait_ms = 0, wait_max_ms = 0;   // queued -> handed to the engine
+    double   ttl_ms  = 0;        // --ttl / /ttl: how long a message may wait (0 = forever)
+    uint64_t expired = 0, expired_msgs = 0;  // chunks / messages dropped unspoken by their TTL
+    uint32_t last_expired_msg = 0;
+};
+static Lane g_lanes[] = { { "alert" }, { "announce" }, { "chat" } };
+constexpr int kLaneCount = (int)(sizeof(g_lanes) / sizeof(g_lanes[0]));
+constexpr int kChatLane  = kLaneCount - 1;   // main --port, and anything not in a message
+
+static int lane_find(const std::string& name){
+    for (int k = 0; k < kLaneCount; ++k) if (name == g_lanes[k].name) return k;
+    return -1;
+}
+
+// Sources: a connection is "client-N" until it sends /source NAME; the GUI, --selftest and
+// the dedupe summaries are "local". Named sources keep their weight and counters across
+// reconnects; a client-N entry goes when its connection closes.
+// When the queue fills up, the sources over their weighted share of it pay: their
+// connections stop being read and their messages are the ones evicted, so a flood does not
+// stall or push out anyone else's.
+constexpr double kQuantumMs   = 1500;        // speech per turn at weight 1
+constexpr double kMinWeight   = 0.05;
+static const char kLocalSource[] = "local";
+struct Source {
+    double   weight   = 1;       // --weight NAME=W, /source weight NAME W
+    double   debt     = 0;       // overspent deficit of its last flow, charged to the next
+    uint64_t chunks   = 0;       // handed to the engine
+    double   speak_ms = 0;       // estimated speech handed to the engine
+    size_t   queued   = 0;       // chunks in its flows
+    SpeechCost queued_cost;      // of those chunks
+    bool     paused   = false;   // over its share of a full queue: its connections are not read
+    bool     closed   = false;   // client-N whose connection is gone; erased once its flows drain
+};
+static std::map<std::string, Source> g_sources;
+static std::map<uint32_t, std::string> g_conn_names;   // live connection id -> source name
+
+static bool is_anonymous(const std::string& name){ return name.compare(0, 7, "client-") == 0; }
+
+static std::string source_of_conn(uint32_t conn){
+    if (!conn) return kLocalSource;
+    auto it = g_conn_names.find(conn);
+    if (it == g_conn_names.end()) it = g_conn_names.emplace(conn, "client-" + std::to_string(conn)).first;
+    return it->second;
+}
+
+// Totals over all lanes, kept as chunks come and go, plus overflow counters
+struct QueueStats {
+    size_t   chunks = 0, bytes = 0;
+    uint64_t dropped_msgs = 0, dropped_chunks = 0;
+    uint64_t deferred = 0;       // times client reads were paused (backpressure)
+    bool     paused = false;
+    DWORD    paused_at = 0;
+    double   paused_ms = 0;
+};
+static QueueStats g_qs;
+
+static size_t chunk_bytes(const Chunk& c){ return c.text.size() * sizeof(wchar_t); }
+
+// Costs are sums of counts, so a lane's total is kept exactly as chunks come and go, and
+// priced (rate, calibration) only when read.
+static SpeechCost add_cost(SpeechCost a, const SpeechCost& b){
+    a.syllables += b.syllables; a.breaks += b.breaks; a.pause_cs += b.pause_cs;
+    return a;
+}
+static SpeechCost sub_cost(SpeechCost a, const SpeechCost& b){
+    a.syllables -= b.syllables; a.breaks -= b.breaks; a.pause_cs -= b.pause_cs;
+    return a;
+}
+
+// back: the newest chunk instead of the next one
+static void pop_chunk(Lane& lane, Flow& f, bool back = false){
+    const Chunk& c = back ? f.q.back() : f.q.front();
+    Source& src = g_sources[f.source];
+    g_qs.bytes -= chunk_bytes(c);
+    --g_qs.chunks;
+    --lane.depth;
+    lane.cost = sub_cost(lane.cost, c.cost);
+    --src.queued;
+    src.queued_cost = sub_cost(src.queued_cost, c.cost);
+    if (back) f.q.pop_back();
+    else f.q.pop_front();
+}
+
+// Takes drained flows out of the rotation. Only an overspent deficit outlives its flow:
+// a source that keeps sending one long message at a time still pays for each.
+static void drop_empty_flows(Lane& lane){
+    for (size_t i = 0; i < lane.flows.size(); ){
+        Flow& f = lane.flows[i];
+        if (!f.q.empty()){ ++i; continue; }
+        const std::string name = std::move(f.source);
+        const double debt = std::min(0.0, f.deficit);
+        lane.flows.erase(lane.flows.begin() + i);
+        Source& src = g_sources[name];
+        if (src.closed && !src.queued) g_sources.erase(name);
+        else src.debt = debt;
+        if (i < lane.rr) --lane.rr;
+        else if (i == lane.rr){ lane.turn = false; lane.cur_msg = 0; }
+    }
+    if (lane.rr >= lane.flows.size()) lane.rr = 0;
+}
+
+// Lane of a line from the network (or WM_APP_SPEAK): tag lane + 1 for a --lane-port, 0 for
+// the main port
+static int lane_of_tag(int tag){
+    return (tag > 0 && tag <= kLaneCount) ? tag - 1 : kChatLane;
+}
+constexpr int kIngressBatch = 256;
+
+// Drops the chunks at the front of each flow of `lane` whose TTL has run out. A flow is FIFO
+// and its messages mostly share the lane's TTL, so expired chunks gather at the front: the
+// check stops at the first live one instead of scanning the flow. (A [[ttl]] shorter than the
+// ones queued ahead of it is caught when it reaches the front.)
+static void expire_front(Lane& lane, DWORD now){
+    unsigned n = 0;
+    for (Flow& f : lane.flows){
+        std::deque<Chunk>& q = f.q;
+        while (!q.empty() && q.front().expires && (int32_t)(now - q.front().expires) >= 0){
+            if (!q.front().msg || q.front().msg != lane.last_expired_msg) ++lane.expired_msgs;
+            lane.last_expired_msg = q.front().msg;
+            pop_chunk(lane, f);
+            ++n;
+        }
+    }
+    if (!n) return;
+    drop_empty_flows(lane);
+    lane.expired += n;
+    dprintf("[queue] %s: %u stale chunks expired", lane.name, n);
+}
+
+static bool lanes_empty(){
+    for (const Lane& l : g_lanes) if (l.depth) return false;
+    return true;
+}
+
+// Chunks handed to the engine since the last AudioStop; their measured time calibrates the
+// duration estimator.
+static SpeechRun g_run;
+static DWORD     g_run_t0      = 0;       // GetTickCount() at the run's first TextDataStarted
+static bool      g_run_started = false;
+
+// Estimated speech ahead of a new message on `lane`: that lane and the ones above it, plus
+// what is left of the current run (lower lanes wait, so they do not count). Other sources'
+// flows are counted in full, so under contention this is an upper bound.
+static double queued_ms(int lane = kChatLane){
+    const int rate = tts_rate_percent_ui();
+    SpeechCost queued;
+    for (int k = 0; k <= lane; ++k) queued = add_cost(queued, g_lanes[k].cost);
+    double ms = speech_estimate_ms(queued, rate);
+    if (g_run.chunks){
+        double left = speech_run_estimate_ms(g_run) - (g_run_started ? (double)(GetTickCount() - g_run_t0) : 0.0);
+        if (left > 0) ms += left;
+    }
+    return ms;
+}
+
+// Time budget of the message being enqueued (--max-msg-seconds); push_chunk() spends it and
+// cuts the message where it runs out.
+struct MsgBudget {
+    bool   active = false;
+    bool   cut    = false;
+    int    lane   = kChatLane;
+    uint32_t id   = 0;           // tags its chunks, so kick_if_idle() only merges within one message
+    std::string source = kLocalSource;   // flow its chunks join
+    DWORD  expires = 0;          // GetTickCount() after which its chunks are dropped unspoken (0 = never)
+    double left_ms = 0, spent_ms = 0, wait_ms = 0;
+};
+static MsgBudget g_msg;
+static uint32_t  g_msg_seq = 0;
+
+// Queue text stays UTF-16 (what the encoder and SAPI take); the UTF-8 copies below exist only
+// for the log, so they are skipped unless a log sink is actually listening.
+static bool trace_on(){ return g_headless && log_is_enabled(); }
+
+// Drops the message at the front (back: the back) of flow fi of lane k, every chunk of it
+// still queued there
+static void evict_message(int k, size_t fi, bool back = false){
+    Lane& lane = g_lanes[k];
+    Flow& f = lane.flows[fi];
+    auto end = [&]() -> const Chunk& { return back ? f.q.back() : f.q.front(); };
+    const uint32_t msg = end().msg;
+    size_t n = 0;
+    do { pop_chunk(lane, f, back); ++n; } while (msg && !f.q.empty() && end().msg == msg);
+    ++g_qs.dropped_msgs;
+    g_qs.dropped_chunks += n;
+    dprintf("[queue] full: dropped a queued %s message from %s (%u chunks)", lane.name, f.source.c_str(), (unsigned)n);
+    drop_empty_flows(lane);
+}
+
+// Queued speech of a source per unit of weight: the sources with the most are the ones
+// over their share
+static double source_load(const Source& src, int rate){
+    return speech_estimate_ms(src.queued_cost, rate) / src.weight;
+}
+
+// Keeps the queue within --queue-max-chunks/--queue-max-kb/--max-queue-seconds before a
+// chunk of `bytes`/`ms` from `source` joins `lane`. Only sources at least as far over their
+// share as `source` (counting the new chunk) give up a queued message, the heaviest first,
+// never the one being queued; when that is `source` itself under "newest", or it has
+// nothing to give, false = the new chunk has to go. --queue-policy picks which message:
+// the source's newest or oldest, or its first in the lowest lane. Only "oldest" reaches
+// above the new chunk's lane: otherwise chat never pushes out an alert.
+static bool make_room(int lane, const std::string& source, size_t bytes, double ms){
+    auto over = [&](){
+        if (g_queue_max_chunks && g_qs.chunks + 1 > g_queue_max_chunks) return true;
+        if (g_queue_max_bytes && g_qs.bytes + bytes > g_queue_max_bytes) return true;
+        return g_max_queue_ms > 0 && queued_ms(kChatLane) + ms > g_max_queue_ms;
+    };
+    auto evictable = [](const Chunk& c){
+        return !(g_msg.active && c.msg == g_msg.id);
+    };
+    if (over()){   // stale messages go first
+        const DWORD now = GetTickCount();
+        for (Lane& l : g_lanes) expire_front(l, now);
+    }
+    // the flow of `name` holding the message to drop: its back chunk under "newest"
+    auto pick = [&](const std::string& name, int& vk, size_t& vf){
+        const DWORD now = GetTickCount();
+        bool found = false;
+        DWORD best = 0;
+        for (int k = kLaneCount - 1; k >= (g_queue_policy == DROP_OLDEST ? 0 : lane); --k)
+            for (const Flow& f : g_lanes[k].flows){
+                if (f.source != name) continue;   // (one flow per source and lane)
+                const Chunk& c = g_queue_policy == DROP_NEWEST ? f.q.back() : f.q.front();
+                const DWORD age = now - c.queued_at;
+                if (evictable(c) && (!found || (g_queue_policy == DROP_OLDEST && age > best)
+                                            || (g_queue_policy == DROP_NEWEST && age < best))){
+                    found = true; best = age; vk = k; vf = (size_t)(&f - g_lanes[k].flows.data());
+                }
+                break;
+            }
+        return found;
+    };
+    const int rate = tts_rate_percent_ui();
+    const double own = source_load(g_sources[source], rate) + ms / g_sources[source].weight;
+    while (over()){
+        std::vector<std::pair<double, const std::string*>> heavy;
+        for (const auto& kv : g_sources){
+            if (!kv.second.queued || kv.first == source) continue;
+            const double load = source_load(kv.second, rate);
+            if (load >= own) heavy.emplace_back(load, &kv.first);
+        }
+        std::sort(heavy.begin(), heavy.end(), [](const auto& x, const auto& y){ return x.first > y.first; });
+        if (g_queue_policy != DROP_NEWEST) heavy.emplace_back(own, &source);   // then its own older messages
+        int victim = -1;
+        size_t vf = 0;
+        for (const auto& h : heavy) if (pick(*h.second, victim, vf)) break;
+        if (victim < 0) return false;
+        evict_message(victim, vf, g_queue_policy == DROP_NEWEST);
+    }
+    return true;
+}
 
 static void push_chunk(std::wstring text){
-    if (g_headless){
+    SpeechCost cost = speech_cost(text);
+    const int rate = tts_rate_percent_ui();
+    double ms = speech_estimate_ms(cost, rate);
+    if (g_msg.active){
+        if (g_msg.cut) return;   // the rest of an over-budget message is dropped
+        if (ms > g_msg.left_ms){
+            g_msg.cut = true;
+            speech_trim(text, g_msg.left_ms, rate);
+            cost = speech_cost(text);
+            if (!cost.syllables) return;
+            ms = speech_estimate_ms(cost, rate);
+        }
+    }
+    const int lane_ix = g_msg.active ? g_msg.lane : kChatLane;
+    const std::string& source = g_msg.active ? g_msg.source : std::string(kLocalSource);
+    if (!make_room(lane_ix, source, text.size() * sizeof(wchar_t), ms)){
+        if (!g_msg.active || !g_msg.cut) ++g_qs.dropped_msgs;
+        ++g_qs.dropped_chunks;
+        g_msg.cut = g_msg.active;
+        return;
+    }
+    if (g_msg.active){
+        g_msg.left_ms  -= ms;
+        g_msg.spent_ms += ms;
+    }
+    Lane& lane = g_lanes[lane_ix];
+    if (trace_on()){
         std::string u8 = w_to_u8(text);
-        dprintf("[queue] push: \"%s\"", u8.c_str());
+        dprintf("[queue] push %s/%s: \"%s\"", lane.name, source.c_str(), u8.c_str());
+    }
+    Source& src = g_sources[source];
+    auto f = std::find_if(lane.flows.begin(), lane.flows.end(), [&](const Flow& x){ return x.source == source; });
+    if (f == lane.flows.end()){   // joins the rotation last, with whatever it overspent before
+        lane.flows.push_back(Flow{ source, {}, src.debt });
+        src.debt = 0;
+        f = lane.flows.end() - 1;
+    }
+    ++src.queued;
+    src.queued_cost = add_cost(src.queued_cost, cost);
+    g_qs.bytes += text.size() * sizeof(wchar_t);
+    ++g_qs.chunks;
+    f->q.push_back({ std::move(text), cost, GetTickCount(), g_msg.active ? g_msg.id : 0u, g_msg.active ? g_msg.expires : 0u });
+    lane.peak = std::max(lane.peak, ++lane.depth);
+    lane.cost = add_cost(lane.cost, cost);
+}
+
+// ttl_ms: [[ttl S]] for this message; negative = the lane's TTL
+static void begin_message(int lane, const std::string& source, double ttl_ms = -1){
+    g_msg = MsgBudget{};
+    g_msg.active  = true;
+    g_msg.lane    = lane;
+    g_msg.source  = source;
+    if (ttl_ms < 0) ttl_ms = g_lanes[lane].ttl_ms;
+    if (ttl_ms > 0){
+        g_msg.expires = GetTickCount() + (DWORD)ttl_ms;
+        if (!g_msg.expires) g_msg.expires = 1;
     }
-    g_q.push_back({ std::move(text) });
+    if (++g_msg_seq == 0) ++g_msg_seq;   // 0 is "no message"
+    g_msg.id      = g_msg_seq;
+    g_msg.wait_ms = queued_ms(lane);
+    g_msg.left_ms = g_max_msg_ms > 0 ? g_max_msg_ms : 1e12;
+}
+
+// ETA of the message on the status socket: seconds until it starts, seconds of speech, and
+// whether a budget cut it short (speak=0.0 cut=1: dropped, the queue was full).
+static void end_message(){
+    g_msg.active = false;
+    if (g_msg.spent_ms <= 0 && !g_msg.cut) return;
+    char line[128];
+    int n = snprintf(line, sizeof(line), "ETA wait=%.1f speak=%.1f cut=%d lane=%s\n",
+                     g_msg.wait_ms / 1000.0, g_msg.spent_ms / 1000.0, g_msg.cut ? 1 : 0,
+                     g_lanes[g_msg.lane].name);
+    if (n <= 0 || n >= (int)sizeof(line)) return;
+    if (g_msg.cut) dprintf("[budget] message cut to %.1f s (%.1f s queued ahead)", g_msg.spent_ms / 1000.0, g_msg.wait_ms / 1000.0);
+    else if (trace_on()) dprintf("[budget] %.*s", n - 1, line);
+    status_server_broadcast(line, (size_t)n);
 }
 
 // [[pause 500]]  →  " \!sf50 " and " \!br " boundary
 static void expand_inline_pauses_and_enqueue(const std::string& line){
     size_t i=0, n=line.size();
-    auto push_text = [&](const std::string& s){
-        if (s.empty()) return;
-        push_chunk(u8_to_w(s));
+    auto push_text = [&](size_t at, size_t len){
+        if (!len) return;
+        push_chunk(u8_to_w(line.data() + at, len));
         push_chunk(L" \\!br "); // force boundary between logical chunks
     };
     while (i<n){
         size_t p = line.find("[[pause", i);
-        if (p == std::string::npos) { push_text(line.substr(i)); break; }
-        if (p > i) push_text(line.substr(i, p-i));
+        if (p == std::string::npos) { push_text(i, n-i); break; }
+        if (p > i) push_text(i, p-i);
 
         size_t close = line.find("]]", p);
         int ms = 0;
@@ -140,12 +516,45 @@ static bool maybe_handle_inline_cmds(const std::string& line){
 }
 
 
-// Send one queued chunk as-is (no internal \!br splitting).
-// If the NEXT queued item is a standalone \!br, append it to the same speak
-// so vendor pauses anchored to a boundary still work naturally.
-static void kick_if_idle(){
-    if (g_eng.inflight.load(std::memory_order_relaxed) > 0) return;
-    if (g_q.empty()) return;
+// Weighted DRR: the flow of `lane` that speaks next. The flow whose turn it is gets its
+// quantum once per turn and keeps the turn while its deficit covers its next chunk (or that
+// chunk continues the message it started); otherwise the turn passes on, the deficit kept.
+// Every pass adds a quantum to each flow, so this ends.
+static Flow& drr_pick(Lane& lane){
+    const int rate = tts_rate_percent_ui();
+    for (;;){
+        if (lane.rr >= lane.flows.size()) lane.rr = 0;
+        Flow& f = lane.flows[lane.rr];
+        const Chunk& c = f.q.front();
+        if (lane.cur_msg && c.msg == lane.cur_msg) return f;
+        if (!lane.turn){
+            auto src = g_sources.find(f.source);
+            f.deficit += kQuantumMs * (src != g_sources.end() ? src->second.weight : 1.0);
+            lane.turn = true;
+        }
+        if (f.deficit >= speech_estimate_ms(c.cost, rate)) return f;
+        lane.turn = false;
+        lane.cur_msg = 0;
+        ++lane.rr;
+    }
+}
+
+// Send queued chunks as-is (no internal \!br splitting), from the highest non-empty lane and
+// the flow drr_pick() chooses. If the NEXT item in that flow is a standalone \!br, append it to the same speak
+// so vendor pauses anchored to a boundary still work naturally. Further chunks of the same
+// message ride along while the submission stays within --coalesce-chars/--coalesce-seconds:
+// one TextData call and one TextDataStarted/Done round trip instead of one per fragment, and
+// no engine restart gap between them.
+static bool submit_next(){
+    Lane* lane = nullptr;
+    const DWORD now0 = GetTickCount();
+    for (Lane& l : g_lanes){
+        expire_front(l, now0);
+        if (l.depth){ lane = &l; break; }
+    }
+    if (!lane) return false;
+    Flow& flow = drr_pick(*lane);
+    std::deque<Chunk>& q = flow.q;
 
     auto is_just_br = [](const std::wstring& s)->bool{
         // trim spaces
@@ -156,31 +565,118 @@ static void kick_if_idle(){
         return s.compare(a, 4, L"\\!br") == 0;
     };
 
-    // take exactly one chunk
-    std::wstring w = g_q.front().text;
-    g_q.pop_front();
-
-    // if next is a bare \!br, glue it
-    if (!g_q.empty() && is_just_br(g_q.front().text)) {
-        w += g_q.front().text;
-        g_q.pop_front();
-    }
+    std::wstring w;
+    SpeechCost cost;
+    const DWORD now = GetTickCount();
+    const uint32_t msg = q.front().msg;
+    unsigned taken = 0;
+    // take one chunk
+    auto take = [&](){
+        Chunk& c = q.front();
+        const double waited = (double)(now - c.queued_at);
+        w += c.text;
+        cost = add_cost(cost, c.cost);
+        pop_chunk(*lane, flow);
+        ++taken;
+        ++lane->served;
+        lane->wait_ms += waited;
+        lane->wait_max_ms = std::max(lane->wait_max_ms, waited);
+
+        // if next is a bare \!br, glue it
+        if (!q.empty() && is_just_br(q.front().text)) {
+            w += q.front().text;
+            cost.breaks += q.front().cost.breaks;
+            pop_chunk(*lane, flow);
+        }
+    };
+    take();
+    const int rate = tts_rate_percent_ui();
+    while (msg && g_coalesce_chars && !q.empty() && q.front().msg == msg
+           && w.size() + q.front().text.size() <= g_coalesce_chars
+           && speech_estimate_ms(add_cost(cost, q.front().cost), rate) <= g_coalesce_ms)
+        take();
+
+    // charged what it took, coalesced chunks included
+    const double spent = speech_estimate_ms(cost, rate);
+    Source& src = g_sources[flow.source];
+    src.chunks   += taken;
+    src.speak_ms += spent;
+    flow.deficit -= spent;
+    lane->cur_msg = msg;
+    if (q.empty()) drop_empty_flows(*lane);
 
     std::wstring prefix = tts_vendor_prefix_from_ui();
     if (!prefix.empty()) {
-        w = prefix + w;
+        w.insert(0, prefix);
     }
 
-    if (g_headless) {
+    if (trace_on()) {
         std::string payload = w_to_u8(w);
         dprintf("[speak] text=\"%s\"", payload.c_str());
     }
 
     const bool tagged = text_looks_tagged(w);
     HRESULT hr = tts_speak(g_eng, w, tagged);
+    if (SUCCEEDED(hr)) speech_run_add(g_run, cost, rate);
     if (g_headless) {
-        dprintf("[speak] hr=0x%08lx tagged=%d len=%u", hr, tagged?1:0, (unsigned)w.size());
+        dprintf("[speak] hr=0x%08lx tagged=%d len=%u chunks=%u inflight=%ld", hr, tagged?1:0, (unsigned)w.size(), taken,
+                g_eng.inflight.load(std::memory_order_relaxed));
+    }
+    return SUCCEEDED(hr);
+}
+
+// Keep up to --submit-window utterances with the engine, so the next one is already in
+// TextData when the current one finishes instead of waiting for TextDataDone to come back
+// through the message queue. The window is also how far ahead of a new alert the engine
+// is committed, so it stays small.
+// Once the queue is 90% full (until it is below 75%), the sources holding at least their
+// weighted share of it stop being read, so TCP flow control pushes back on those producers
+// while the rest keep talking.
+static void update_backpressure(){
+    double use = 0;
+    if (g_queue_max_chunks) use = std::max(use, (double)g_qs.chunks / g_queue_max_chunks);
+    if (g_queue_max_bytes)  use = std::max(use, (double)g_qs.bytes / g_queue_max_bytes);
+    if (g_max_queue_ms > 0 && (g_qs.chunks || g_qs.paused)) use = std::max(use, queued_ms(kChatLane) / g_max_queue_ms);
+    const bool full = use >= (g_qs.paused ? 0.75 : 0.9);
+    if (full != g_qs.paused){
+        g_qs.paused = full;
+        if (full){
+            ++g_qs.deferred;
+            g_qs.paused_at = GetTickCount();
+            dprintf("[queue] full (%u chunks): pausing the sources over their share", (unsigned)g_qs.chunks);
+        } else {
+            g_qs.paused_ms += (double)(GetTickCount() - g_qs.paused_at);
+            dprintf("[queue] drained: resuming client reads");
+        }
+    }
+    // share of the queue by estimated speech (by chunks while nothing has a duration)
+    const int rate = tts_rate_percent_ui();
+    double total = 0, weights = 0;
+    for (auto& kv : g_sources){
+        if (!kv.second.queued) continue;
+        total   += speech_estimate_ms(kv.second.queued_cost, rate);
+        weights += kv.second.weight;
     }
+    for (auto& kv : g_sources){
+        Source& src = kv.second;
+        const double held = total > 0 ? speech_estimate_ms(src.queued_cost, rate) / total
+                                      : (double)src.queued / std::max<size_t>(g_qs.chunks, 1);
+        src.paused = full && src.queued && held >= src.weight / weights;
+    }
+    static std::vector<uint32_t> paused;
+    std::vector<uint32_t> ids;
+    for (const auto& kv : g_conn_names){
+        auto src = g_sources.find(kv.second);
+        if (src != g_sources.end() && src->second.paused) ids.push_back(kv.first);
+    }
+    if (ids == paused) return;
+    paused = ids;
+    server_set_paused(std::move(ids));
+}
+
+static void kick_if_idle(){
+    while (g_eng.inflight.load(std::memory_order_relaxed) < g_submit_window && submit_next()) {}
+    update_backpressure();
 }
 
 
@@ -227,17 +723,22 @@ static void enqueue_selftest(){
 
 // Posn polling
 static UINT_PTR g_posn_timer = 0;
+static UINT_PTR g_dedupe_timer = 0;           // --dedupe-count: closes windows while input is quiet
 static void start_posn_poll(){ if (!g_posn_timer && g_posn_poll_ms>0) g_posn_timer = SetTimer(g_hwnd, 42, (UINT)g_posn_poll_ms, nullptr); }
 static void stop_posn_poll(){ if (g_posn_timer){ KillTimer(g_hwnd, g_posn_timer); g_posn_timer=0; } }
 
-// --- VOX debug logging (guarded by g_headless) ---
+// --- VOX debug logging (guarded by trace_on()) ---
 static std::string replace_all(std::string s, const std::string& a, const std::string& b){
     size_t p = 0;
     while ((p = s.find(a, p)) != std::string::npos) { s.replace(p, a.size(), b); p += b.size(); }
     return s;
 }
-static void log_vox_transform(const std::string& in_u8, const std::wstring& out_w){
-    if (!g_headless) return;
+static void log_vox_in(const std::string& in_u8){
+    if (!trace_on()) return;
+    dprintf("[vox] in : \"%s\"", in_u8.c_str());
+}
+static void log_vox_out(const std::wstring& out_w){
+    if (!trace_on()) return;
     std::string out_u8 = w_to_u8(out_w);
 
     // pretty for readability in logs (doesn't affect what we send to TTS)
@@ -246,17 +747,353 @@ static void log_vox_transform(const std::string& in_u8, const std::wstring& out_
     pretty = replace_all(pretty, "\\!wH0", "[wH0]");
     pretty = replace_all(pretty, "\\!br",  "[BR]");
 
-    dprintf("[vox] in : \"%s\"", in_u8.c_str());
     dprintf("[vox] out: \"%s\"", out_u8.c_str());
     dprintf("[vox] viz: \"%s\"", pretty.c_str());
 }
 
 
-// Enqueue one inbound line, applying --vox if enabled.
-static void enqueue_incoming_text(const std::string& line){
-    if (g_headless){
+// /stats: counters to the log and as STAT lines on the status socket
+static void report_rulepacks(){
+    std::string line = "STAT rulepacks " + vox_rulepack_list() + "\n";
+    dprintf("[stats] %.*s", (int)line.size() - 1, line.c_str());
+    status_server_broadcast(line.c_str(), line.size());
+}
+
+static void report_speech_time(){
+    SpeechModelStats m = speech_model_stats();
+    char line[160];
+    int n = snprintf(line, sizeof(line), "STAT speech_time scale=%.3f error=%.3f samples=%u queued_s=%.1f\n",
+                     m.scale, m.error, m.samples, queued_ms() / 1000.0);
+    if (n <= 0 || n >= (int)sizeof(line)) return;
+    dprintf("[stats] %.*s", n - 1, line);
+    status_server_broadcast(line, (size_t)n);
+}
+
+static void report_lanes(){
+    for (const Lane& l : g_lanes){
+        char line[224];
+        int n = snprintf(line, sizeof(line), "STAT lane %s depth=%u peak=%u chunks=%llu wait_avg_ms=%.0f wait_max_ms=%.0f"
+                         " ttl_s=%.0f expired=%llu expired_msgs=%llu\n",
+                         l.name, (unsigned)l.depth, (unsigned)l.peak, (unsigned long long)l.served,
+                         l.served ? l.wait_ms / l.served : 0.0, l.wait_max_ms,
+                         l.ttl_ms / 1000.0, (unsigned long long)l.expired, (unsigned long long)l.expired_msgs);
+        if (n <= 0 || n >= (int)sizeof(line)) continue;
+        dprintf("[stats] %.*s", n - 1, line);
+        status_server_broadcast(line, (size_t)n);
+    }
+}
+
+static void report_queue(){
+    char line[224];
+    const double paused_ms = g_qs.paused_ms + (g_qs.paused ? (double)(GetTickCount() - g_qs.paused_at) : 0.0);
+    int n = snprintf(line, sizeof(line),
+        "STAT queue chunks=%u/%u bytes=%u/%u policy=%s dropped_msgs=%llu dropped_chunks=%llu deferred=%llu paused=%d paused_s=%.1f\n",
+        (unsigned)g_qs.chunks, (unsigned)g_queue_max_chunks, (unsigned)g_qs.bytes, (unsigned)g_queue_max_bytes,
+        kPolicyNames[g_queue_policy], (unsigned long long)g_qs.dropped_msgs, (unsigned long long)g_qs.dropped_chunks,
+        (unsigned long long)g_qs.deferred, g_qs.paused ? 1 : 0, paused_ms / 1000.0);
+    if (n <= 0 || n >= (int)sizeof(line)) return;
+    dprintf("[stats] %.*s", n - 1, line);
+    status_server_broadcast(line, (size_t)n);
+}
+
+static void report_dedupe(){
+    DedupeStats d = dedupe_stats();
+    char line[160];
+    int n = snprintf(line, sizeof(line), "STAT dedupe window_s=%.1f seen=%llu dropped=%llu repeats=%llu live=%u collisions=%llu\n",
+                     g_dedupe_ms / 1000.0, (unsigned long long)d.seen, (unsigned long long)d.dropped,
+                     (unsigned long long)d.repeats, (unsigned)d.live, (unsigned long long)d.collisions);
+    if (n <= 0 || n >= (int)sizeof(line)) return;
+    dprintf("[stats] %.*s", n - 1, line);
+    status_server_broadcast(line, (size_t)n);
+}
+
+static void report_ingress(){
+    IngressStats st = ingress_stats();
+    char line[160];
+    int n = snprintf(line, sizeof(line), "STAT ingress lines=%llu wakeups=%llu full=%llu high_water=%u/%u\n",
+                     (unsigned long long)st.lines, (unsigned long long)st.wakeups, (unsigned long long)st.full,
+                     st.high_water, st.capacity);
+    if (n <= 0 || n >= (int)sizeof(line)) return;
+    dprintf("[stats] %.*s", n - 1, line);
+    status_server_broadcast(line, (size_t)n);
+}
+
+static void report_sanitize(){
+    char line[128];
+    int n = snprintf(line, sizeof(line), "STAT sanitize enabled=%d urls=%u repeats=%u dropped=%u\n",
+                     g_sanitize ? 1 : 0, g_sanitize_stats.urls, g_sanitize_stats.repeats, g_sanitize_stats.dropped);
+    if (n <= 0 || n >= (int)sizeof(line)) return;
+    dprintf("[stats] %.*s", n - 1, line);
+    status_server_broadcast(line, (size_t)n);
+}
+
+static void report_lexicon(){
+    LexiconRef lx = lexicon_current();
+    std::string line = "STAT lexicon " + (lx ? lexicon_describe(*lx) : std::string("entries=0")) + "\n";
+    dprintf("[stats] %.*s", (int)line.size() - 1, line.c_str());
+    status_server_broadcast(line.c_str(), line.size());
+}
+
+// Upper bound of the bucket holding quantile q of a VoxStageStats histogram
+static unsigned long long stage_quantile(const VoxStageStats& s, double q){
+    unsigned long long want = (unsigned long long)(q * (double)s.calls + 0.5), seen = 0;
+    for (int k = 0; k < VOX_STAGE_HIST; ++k){
+        seen += s.hist[k];
+        if (seen >= want && seen) return 2ull << k;
+    }
+    return s.ticks_max;
+}
+
+// One line per VOX stage that ran: call count, ticks (avg, p50/p99 bucket bounds, max) and
+// how much the stage grew its text (total out/in and the worst single call).
+static void report_vox_stages(){
+    VoxStageStats st[VOX_STAGE_COUNT];
+    if (!vox_stage_stats(st)) return;
+    for (int k = 0; k < VOX_STAGE_COUNT; ++k){
+        const VoxStageStats& s = st[k];
+        if (!s.calls) continue;
+        char line[320];
+        int n = snprintf(line, sizeof(line),
+            "STAT vox_stage %s calls=%llu %s_avg=%llu p50<=%llu p99<=%llu max=%llu growth=%.3f growth_max=%.3f\n",
+            vox_stage_name(k), (unsigned long long)s.calls, vox_stage_tick_unit(),
+            (unsigned long long)(s.ticks / s.calls), stage_quantile(s, 0.50), stage_quantile(s, 0.99),
+            (unsigned long long)s.ticks_max,
+            s.units_in ? (double)s.units_out / (double)s.units_in : 0.0, s.growth_max / 1000.0);
+        if (n <= 0 || n >= (int)sizeof(line)) continue;   // never a cut line without its '\n'
+        dprintf("[stats] %.*s", n - 1, line);
+        status_server_broadcast(line, (size_t)n);
+    }
+}
+
+// /pack NAME | /pack load PATH | /pack
+static void handle_pack_cmd(const std::string& args){
+    if (args.empty()){ report_rulepacks(); return; }
+    if (args.compare(0, 5, "load ") == 0){
+        size_t p = 5; while (p < args.size() && isspace((unsigned char)args[p])) ++p;
+        std::string name; std::wstring err;
+        if (vox_rulepack_load(u8_to_w(args.substr(p)), name, err)){
+            vox_cache_clear();   // entries made with a replaced pack can't be hit again
+            dprintf("[pack] loaded \"%s\"", name.c_str());
+        } else {
+            dprintf("[pack] %s", w_to_u8(err).c_str());
+        }
+        return;
+    }
+    if (vox_rulepack_select(args)) dprintf("[pack] default is now \"%s\"", args.c_str());
+    else dprintf("[pack] no rule pack named \"%s\" (have: %s)", args.c_str(), vox_rulepack_list().c_str());
+}
+
+// /lexicon | /lexicon reload | /lexicon load PATH
+static void handle_lexicon_cmd(const std::string& args){
+    if (args.empty()){ report_lexicon(); return; }
+    std::wstring err; bool ok;
+    if (args == "reload") ok = lexicon_reload(err);
+    else if (args.compare(0, 5, "load ") == 0){
+        size_t p = 5; while (p < args.size() && isspace((unsigned char)args[p])) ++p;
+        ok = lexicon_load(u8_to_w(args.substr(p)), err);
+    } else {
+        dprintf("[lexicon] unknown command \"%s\" (reload | load PATH)", args.c_str());
+        return;
+    }
+    if (ok) dprintf("[lexicon] %s", lexicon_describe(*lexicon_current()).c_str());
+    else    dprintf("[lexicon] %s", w_to_u8(err).c_str());
+}
+
+// (Re)compiles --templates for the current prosody mode, default pack and lexicon
+static bool load_templates(std::wstring& err){
+    return templates_load(g_templates_path, g_vox_enabled, !g_vox_clean, vox_rulepack_get(std::string()),
+                          lexicon_current().get(), err);
+}
+
+static void report_templates(){
+    TemplateSetRef set = templates_current();
+    std::string line = "STAT templates " + (set ? templates_describe(*set) : std::string("count=0")) + "\n";
+    dprintf("[stats] %.*s", (int)line.size() - 1, line.c_str());
+    status_server_broadcast(line.c_str(), line.size());
+}
+
+// /tmpl | /tmpl reload | /tmpl NAME key=value...
+// Only the slot values are encoded; the template text was encoded when it loaded.
+static void handle_tmpl_cmd(const std::string& args, int lane, const std::string& source){
+    if (args.empty()){ report_templates(); return; }
+    if (g_templates_path.empty()){ dprintf("[tmpl] no --templates file"); return; }
+    std::wstring werr;
+    if (args == "reload"){
+        if (load_templates(werr)) dprintf("[tmpl] %s", templates_describe(*templates_current()).c_str());
+        else dprintf("[tmpl] %s", w_to_u8(werr).c_str());
+        return;
+    }
+    TemplateSetRef set = templates_current();
+    if (!set || !templates_match(*set, g_vox_enabled, !g_vox_clean)){
+        if (!load_templates(werr)){ dprintf("[tmpl] %s", w_to_u8(werr).c_str()); return; }
+        set = templates_current();
+    }
+    std::string name, err;
+    std::vector<TemplateArg> kv;
+    std::wstring out;
+    if (!template_parse_call(args, name, kv, err)){ dprintf("[tmpl] %s", err.c_str()); return; }
+    if (g_sanitize)
+        for (TemplateArg& a : kv) chat_sanitize(a.value, &g_sanitize_stats);
+    if (LexiconRef lx = lexicon_current())
+        for (TemplateArg& a : kv) lexicon_rewrite(*lx, a.value);
+    if (!template_render(*set, name, kv, out, err)){ dprintf("[tmpl] %s", err.c_str()); return; }
+    begin_message(lane, source);
+    if (g_vox_enabled){
+        log_vox_out(out);
+        push_chunk(std::move(out));
+    } else {
+        expand_inline_pauses_and_enqueue(w_to_u8(out));
+    }
+    end_message();
+    kick_if_idle();
+}
+
+// /ttl (report) | /ttl LANE SECONDS (0 = no limit)
+static void handle_ttl_cmd(const std::string& args){
+    if (args.empty()){ report_lanes(); return; }
+    size_t sp = args.find(' ');
+    int k = lane_find(args.substr(0, sp));
+    if (k < 0 || sp == std::string::npos){ dprintf("[ttl] usage: /ttl alert|announce|chat SECONDS"); return; }
+    g_lanes[k].ttl_ms = std::max(0.0, atof(args.c_str() + sp + 1) * 1000.0);
+    dprintf("[ttl] %s: %.0f s (0 = no limit)", g_lanes[k].name, g_lanes[k].ttl_ms / 1000.0);
+}
+
+static void report_sources(){
+    double total = 0;
+    for (const auto& kv : g_sources) total += kv.second.speak_ms;
+    for (const auto& kv : g_sources){
+        const Source& src = kv.second;
+        char line[240];
+        int n = snprintf(line, sizeof(line), "STAT source %s weight=%.2f queued=%u paused=%d chunks=%llu speak_s=%.1f share=%.2f\n",
+                         kv.first.c_str(), src.weight, (unsigned)src.queued, src.paused ? 1 : 0,
+                         (unsigned long long)src.chunks, src.speak_ms / 1000.0, total > 0 ? src.speak_ms / total : 0.0);
+        if (n <= 0 || n >= (int)sizeof(line)) continue;
+        dprintf("[stats] %.*s", n - 1, line);
+        status_server_broadcast(line, (size_t)n);
+    }
+}
+
+// "NAME=W" (--weight) or "NAME W" (/source weight); false = malformed
+static bool set_source_weight(const std::string& spec, char sep){
+    size_t at = spec.find(sep);
+    if (at == 0 || at == std::string::npos) return false;
+    double w = atof(spec.c_str() + at + 1);
+    if (!(w > 0)) return false;
+    Source& src = g_sources[spec.substr(0, at)];
+    src.weight = std::max(kMinWeight, w);
+    dprintf("[source] %s: weight %.2f", spec.substr(0, at).c_str(), src.weight);
+    return true;
+}
+
+// /source (report) | /source NAME (name this connection) | /source weight NAME W
+static void handle_source_cmd(const std::string& args, uint32_t conn){
+    if (args.empty()){ report_sources(); return; }
+    if (args.compare(0, 7, "weight ") == 0){
+        if (!set_source_weight(args.substr(7), ' ')) dprintf("[source] usage: /source weight NAME W");
+        return;
+    }
+    if (!conn || args.find(' ') != std::string::npos || args == kLocalSource || is_anonymous(args)){
+        dprintf("[source] cannot name this source \"%s\"", args.c_str());
+        return;
+    }
+    const std::string old = source_of_conn(conn);
+    if (old == args) return;
+    // what it already queued moves to the new name (and a client-N's counters with it)
+    Source& to = g_sources[args];
+    to.closed = false;
+    auto it = g_sources.find(old);
+    if (it != g_sources.end()){
+        to.queued     += it->second.queued;
+        to.queued_cost = add_cost(to.queued_cost, it->second.queued_cost);
+        it->second.queued = 0;
+        it->second.queued_cost = SpeechCost{};
+    }
+    for (Lane& l : g_lanes){
+        auto dst = std::find_if(l.flows.begin(), l.flows.end(), [&](const Flow& f){ return f.source == args; });
+        for (Flow& f : l.flows){
+            if (f.source != old) continue;
+            if (dst == l.flows.end()){ f.source = args; continue; }
+            for (Chunk& c : f.q) dst->q.push_back(std::move(c));
+            f.q.clear();
+        }
+        drop_empty_flows(l);   // (a merged flow's debt lands on `old`, erased below)
+    }
+    it = g_sources.find(old);
+    if (it != g_sources.end() && is_anonymous(old)){   // a name stays with its weight
+        to.chunks   += it->second.chunks;
+        to.speak_ms += it->second.speak_ms;
+        g_sources.erase(it);
+    }
+    g_conn_names[conn] = args;
+    dprintf("[source] %s is now %s", old.c_str(), args.c_str());
+}
+
+// A connection closed (ingress tag < 0): forget it, and its counters if it never had a
+// name (once what it queued has been spoken)
+static void source_closed(uint32_t conn){
+    auto it = g_conn_names.find(conn);
+    if (it == g_conn_names.end()) return;
+    const std::string name = std::move(it->second);
+    g_conn_names.erase(it);
+    if (!is_anonymous(name)) return;
+    auto src = g_sources.find(name);
+    if (src == g_sources.end()) return;
+    if (src->second.queued) src->second.closed = true;
+    else g_sources.erase(src);
+}
+
+// A leading "[[KEY NAME]]" directive ("[[lane alert]]", "[[pack NAME]]") applies to this
+// message only; it is removed from the text and NAME returned ("" when absent).
+static std::string take_directive(std::string& line, const char* key){
+    const std::string open = std::string("[[") + key + " ";
+    size_t i = 0; while (i < line.size() && isspace((unsigned char)line[i])) ++i;
+    if (line.compare(i, open.size(), open) != 0) return std::string();
+    size_t e = line.find("]]", i + open.size());
+    if (e == std::string::npos) return std::string();
+    std::string name = line.substr(i + open.size(), e - (i + open.size()));
+    while (!name.empty() && isspace((unsigned char)name.back())) name.pop_back();
+    size_t r = e + 2; while (r < line.size() && isspace((unsigned char)line[r])) ++r;
+    line.erase(0, r);
+    return name;
+}
+
+static void report_stats(){
+    VoxCacheStats c = vox_cache_stats();
+    char line[256];
+    int n = snprintf(line, sizeof(line),
+        "STAT vox_cache hits=%lu misses=%lu evictions=%lu entries=%lu/%lu bytes=%lu/%lu\n",
+        (unsigned long)c.hits, (unsigned long)c.misses, (unsigned long)c.evictions,
+        (unsigned long)c.entries, (unsigned long)c.max_entries,
+        (unsigned long)c.bytes, (unsigned long)c.max_bytes);
+    if (n > 0 && n < (int)sizeof(line)){
+        dprintf("[stats] %.*s", n - 1, line);
+        status_server_broadcast(line, (size_t)n);
+    }
+    report_rulepacks();
+    report_sanitize();
+    report_dedupe();
+    report_lexicon();
+    report_templates();
+    report_speech_time();
+    report_lanes();
+    report_sources();
+    report_queue();
+    report_ingress();
+    report_vox_stages();
+}
+
+// Enqueue one inbound line, applying --vox if enabled. `lane` is the listen port's lane; a
+// leading [[lane NAME]] overrides it. `conn` is the connection it came from (0 = local).
+static void enqueue_incoming_text(std::string line, int lane, uint32_t conn = 0){
+    if (trace_on()){
         dprintf("[input] raw=\"%s\"", line.c_str());
     }
+    const std::string lane_name = take_directive(line, "lane");
+    if (!lane_name.empty()){
+        int k = lane_find(lane_name);
+        if (k >= 0) lane = k;
+        else dprintf("[lane] no lane named \"%s\"", lane_name.c_str());
+    }
 
     auto is_space = [](char c){ return !!isspace((unsigned char)c); };
     size_t i=0, n=line.size(); while (i<n && is_space(line[i])) ++i;
@@ -268,6 +1105,41 @@ static void enqueue_incoming_text(const std::string& line){
         if (kw=="stop"){
             PostMessageW(g_hwnd, WM_APP_STOP, 0, 0);
             return;
+        } else if (kw=="stats"){
+            std::string arg = line.substr(rest(j));
+            while (!arg.empty() && is_space(arg.back())) arg.pop_back();
+            if (arg=="reset"){
+                vox_stage_stats_reset();
+                dprintf("[stats] VOX stage counters reset");
+            } else {
+                report_stats();
+            }
+            return;
+        } else if (kw=="pack"){
+            std::string args = line.substr(rest(j));
+            while (!args.empty() && is_space(args.back())) args.pop_back();
+            handle_pack_cmd(args);
+            return;
+        } else if (kw=="lexicon"){
+            std::string args = line.substr(rest(j));
+            while (!args.empty() && is_space(args.back())) args.pop_back();
+            handle_lexicon_cmd(args);
+            return;
+        } else if (kw=="tmpl"){
+            std::string args = line.substr(rest(j));
+            while (!args.empty() && is_space(args.back())) args.pop_back();
+            handle_tmpl_cmd(args, lane, source_of_conn(conn));
+            return;
+        } else if (kw=="source"){
+            std::string args = line.substr(rest(j));
+            while (!args.empty() && is_space(args.back())) args.pop_back();
+            handle_source_cmd(args, conn);
+            return;
+        } else if (kw=="ttl"){
+            std::string args = line.substr(rest(j));
+            while (!args.empty() && is_space(args.back())) args.pop_back();
+            handle_ttl_cmd(args);
+            return;
         } else if (kw=="rate" || kw=="pitch"){
             size_t p = rest(j);
             double val=0.0; bool ok=false;
@@ -291,24 +1163,78 @@ static void enqueue_incoming_text(const std::string& line){
         }
     }
 
+    std::string text = line;
+    const std::string ttl_arg   = take_directive(text, "ttl");
+    const std::string pack_name = take_directive(text, "pack");
+    begin_message(lane, source_of_conn(conn), ttl_arg.empty() ? -1.0 : std::max(0.0, atof(ttl_arg.c_str()) * 1000.0));
+    // URLs, emoji and "!!!!!!" cost speech time and engine CPU for nothing
+    if (g_sanitize && chat_sanitize(text, &g_sanitize_stats) && trace_on())
+        dprintf("[sanitize] \"%s\"", text.c_str());
+    // raids and bot loops: the same chat line again within --dedupe-seconds is not spoken
+    if (lane == kChatLane && !dedupe_check(text, GetTickCount())){
+        if (trace_on()) dprintf("[dedupe] dropped \"%s\"", text.c_str());
+        end_message();
+        return;
+    }
+    if (LexiconRef lx = lexicon_current()){
+        size_t hits = lexicon_rewrite(*lx, text);
+        if (hits && trace_on()) dprintf("[lexicon] %u replacements: \"%s\"", (unsigned)hits, text.c_str());
+    }
+
     if (g_vox_enabled) {
-        // VOX: transform then push as a single chunk (no extra splitting)
-        std::wstring w = u8_to_w(line);
-        std::wstring wtag = vox_process(w,!g_vox_clean);
-        log_vox_transform(line, wtag);
-        if (!wtag.empty()) push_chunk(std::move(wtag));
+        // VOX: one chunk per sentence; the first starts speaking while the rest encode.
+        // Repeated lines come straight from the cache.
+        const bool wrap = !g_vox_clean;
+        VoxPackRef pack = vox_rulepack_get(pack_name);   // held until this message is encoded
+        if (!pack){
+            dprintf("[pack] no rule pack named \"%s\"; using the default", pack_name.c_str());
+            pack = vox_rulepack_get(std::string());
+        }
+        std::wstring w = u8_to_w(text);
+        std::vector<std::wstring> chunks;
+        log_vox_in(text);
+        if (vox_cache_lookup(w, wrap, pack->id, chunks)) {
+            if (g_headless) dprintf("[vox] cache hit (%u chunks)", (unsigned)chunks.size());
+            for (auto& c : chunks) { log_vox_out(c); push_chunk(std::move(c)); }
+        } else {
+            VoxStream vs;
+            vox_stream_init(vs, wrap, &pack->rules);
+            vox_stream_feed(vs, w);
+            vox_stream_finish(vs);
+            std::wstring wtag;
+            while (vox_stream_next(vs, wtag)) {
+                log_vox_out(wtag);
+                chunks.push_back(wtag);
+                push_chunk(std::move(wtag));
+                if (chunks.size() == 1) kick_if_idle();
+            }
+            vox_cache_store(w, wrap, pack->id, chunks);
+        }
     } else {
         // Non-VOX: keep your existing inline handling
-        if (!maybe_handle_inline_cmds(line))
-            expand_inline_pauses_and_enqueue(line);
+        if (!maybe_handle_inline_cmds(text))
+            expand_inline_pauses_and_enqueue(text);
     }
+    end_message();
     if (HWND dlg = gui_get_main_hwnd()){
-        auto* s = new std::string(line);
+        auto* s = new std::string(text);
         PostMessageW(dlg, WM_APP_SET_TEXT, 0, (LPARAM)s);
     }
     kick_if_idle();
 }
 
+// --dedupe-count: once a repeated line's window closes, say how often it came
+static void speak_dedupe_repeats(){
+    std::vector<DedupeRepeat> reps;
+    dedupe_expire(GetTickCount(), reps);
+    for (const DedupeRepeat& r : reps){
+        char head[48];
+        if (r.count == 1) snprintf(head, sizeof(head), "Repeated once more: ");
+        else snprintf(head, sizeof(head), "Repeated %u more times: ", r.count);
+        enqueue_incoming_text(head + r.text, kChatLane);
+    }
+}
+
 // ------------------------------------------------------------------
 // WndProc
 static LRESULT CALLBACK WndProc(HWND h, UINT m, WPARAM w, LPARAM l){
@@ -389,10 +1315,27 @@ case WM_APP_GET_DEVICE:{
 
 case WM_APP_STOP: {
     // Hard stop: clear pending queue and reset audio so current utterance halts
-    while (!g_q.empty()) g_q.pop_front();
-    tts_audio_reset(g_eng);               // immediate stop/reset (SAPI4)
-    g_eng.inflight.store(0);              // best-effort local reset
+    for (Lane& lane : g_lanes){
+        lane.flows.clear();
+        lane.rr = lane.depth = 0;
+        lane.cost = SpeechCost{};
+        lane.turn = false;
+        lane.cur_msg = 0;
+    }
+    for (auto it = g_sources.begin(); it != g_sources.end(); ){   // nothing queued, nothing owed
+        Source& src = it->second;
+        if (src.closed){ it = g_sources.erase(it); continue; }
+        src.queued = 0;
+        src.queued_cost = SpeechCost{};
+        src.debt = 0;
+        ++it;
+    }
+    g_qs.chunks = g_qs.bytes = 0;
+    g_run = SpeechRun{};                  // cut short: not a calibration sample
+    g_run_started = false;
+    tts_audio_reset(g_eng);               // immediate stop/reset (SAPI4); new epoch, inflight = 0
     gui_notify_tts_state(false);          // reflect back to GUI
+    update_backpressure();
     if (g_headless) dprintf("[stop] hard stop + clear queue");
     return 0;
 }
@@ -401,13 +1344,31 @@ case WM_APP_STOP: {
 case WM_APP_SPEAK: {
     std::string* txt = (std::string*)l;
     if (!txt) return 0;
-    enqueue_incoming_text(*txt);
+    enqueue_incoming_text(*txt, lane_of_tag((int)w));
     delete txt;
     return 0;
 }
 
+case WM_APP_INGRESS: {
+    // Network lines, one wakeup per batch. At most kIngressBatch per message, so engine
+    // callbacks and the GUI get a turn during a flood; the rest comes with the next wakeup.
+    static std::string line;
+    ingress_begin_drain();
+    int tag = 0, n = 0;
+    uint32_t conn = 0;
+    while (n < kIngressBatch && ingress_pop(line, tag, conn)){
+        if (tag < 0) source_closed(conn);
+        else enqueue_incoming_text(line, lane_of_tag(tag), conn);
+        ++n;
+    }
+    if (n == kIngressBatch) PostMessageW(h, WM_APP_INGRESS, 0, 0);
+    return 0;
+}
+
 case WM_APP_TTS_TEXT_START:
+    if (w != tts_epoch(g_eng)) return 0;  // text flushed by /stop
     g_inflight_local++;
+    if (!g_run_started){ g_run_started = true; g_run_t0 = GetTickCount(); }
     // one-liner: tell the GUI it's busy now
     gui_notify_tts_state(true);
     status_server_broadcast("START\n", 6);
@@ -415,15 +1376,19 @@ case WM_APP_TTS_TEXT_START:
 
 
 case WM_APP_TTS_TEXT_DONE: {
+    if (w != tts_epoch(g_eng)) return 0;
     if (g_inflight_local > 0) g_inflight_local--;
-    if (g_eng.inflight.load(std::memory_order_relaxed) == 0) {
-        kick_if_idle();
-    }
+    kick_if_idle();                       // a slot in the submission window opened
     return 0;
 }
 
 case WM_APP_TTS_AUDIO_DONE: {
-    if (g_eng.inflight.load(std::memory_order_relaxed) == 0 && g_q.empty()) {
+    if (g_eng.inflight.load(std::memory_order_relaxed) == 0) {
+        if (g_run_started) speech_calibrate(g_run, (double)(GetTickCount() - g_run_t0));
+        g_run = SpeechRun{};
+        g_run_started = false;
+    }
+    if (g_eng.inflight.load(std::memory_order_relaxed) == 0 && lanes_empty()) {
         gui_notify_tts_state(false);
         if (g_headless) dprintf("[tts] audio done");
     }
@@ -443,6 +1408,10 @@ case WM_APP_TTS_AUDIO_DONE: {
         }
         return 0;
     }
+    if (w == g_dedupe_timer) {
+        speak_dedupe_repeats();
+        return 0;
+    }
 
         break;
 
@@ -478,8 +1447,51 @@ else if (_wcsicmp(argv[i], L"--list-devices") == 0) {
         else if (a==L"--log" && i+1<argc){ log_set_path(argv[++i]); }
         else if (a==L"--vox"){ g_vox_enabled = true; }
         else if (a==L"--voxclean") { g_vox_enabled = true; g_vox_clean = true; }
+        else if (a==L"--vox-cache" && i+1<argc) g_vox_cache_entries = std::max(0, _wtoi(argv[++i]));
+        else if (a==L"--vox-batch" && i+2<argc){ g_vox_batch_in = argv[++i]; g_vox_batch_out = argv[++i]; }
+        else if (a==L"--vox-batch-threads" && i+1<argc) g_vox_batch_threads = std::max(0, _wtoi(argv[++i]));
+        else if (a==L"--rulepack" && i+1<argc) g_rulepacks.push_back(argv[++i]);
+        else if (a==L"--compile-rulepack" && i+2<argc){ g_compile_src = argv[++i]; g_compile_out = argv[++i]; }
+        else if (a==L"--lexicon" && i+1<argc) g_lexicon_path = argv[++i];
+        else if (a==L"--templates" && i+1<argc) g_templates_path = argv[++i];
+        else if (a==L"--nosanitize") g_sanitize = false;
+        else if (a==L"--dedupe-seconds" && i+1<argc) g_dedupe_ms = std::max(0.0, _wtof(argv[++i]) * 1000.0);
+        else if (a==L"--dedupe-count") g_dedupe_count = true;
+        else if (a==L"--max-msg-seconds" && i+1<argc) g_max_msg_ms = std::max(0.0, _wtof(argv[++i]) * 1000.0);
+        else if (a==L"--max-queue-seconds" && i+1<argc) g_max_queue_ms = std::max(0.0, _wtof(argv[++i]) * 1000.0);
+        else if (a==L"--coalesce-chars" && i+1<argc) g_coalesce_chars = (size_t)std::max(0, _wtoi(argv[++i]));
+        else if (a==L"--coalesce-seconds" && i+1<argc) g_coalesce_ms = std::max(0.0, _wtof(argv[++i]) * 1000.0);
+        else if (a==L"--submit-window" && i+1<argc) g_submit_window = std::max(1, std::min(_wtoi(argv[++i]), 8));
+        else if (a==L"--queue-max-chunks" && i+1<argc) g_queue_max_chunks = (size_t)std::max(0, _wtoi(argv[++i]));
+        else if (a==L"--queue-max-kb" && i+1<argc) g_queue_max_bytes = (size_t)std::max(0, _wtoi(argv[++i])) * 1024;
+        else if (a==L"--queue-policy" && i+1<argc){
+            std::wstring v = argv[++i];
+            if      (v==L"newest") g_queue_policy = DROP_NEWEST;
+            else if (v==L"oldest") g_queue_policy = DROP_OLDEST;
+            else if (v==L"lowest") g_queue_policy = DROP_LOWEST;
+            else dprintf("[queue] unknown --queue-policy \"%s\" (newest|oldest|lowest)", w_to_u8(v).c_str());
+        }
         else if (a==L"--host" && i+1<argc) g_host = argv[++i];
         else if (a==L"--port" && i+1<argc) g_port = _wtoi(argv[++i]);
+        else if (a==L"--ttl" && i+1<argc){
+            std::string spec = w_to_u8(argv[++i]);
+            size_t eq = spec.find('=');
+            int lane = eq == std::string::npos ? -1 : lane_find(spec.substr(0, eq));
+            if (lane >= 0) g_lanes[lane].ttl_ms = std::max(0.0, atof(spec.c_str() + eq + 1) * 1000.0);
+            else dprintf("[ttl] bad --ttl \"%s\" (want alert|announce|chat=SECONDS)", spec.c_str());
+        }
+        else if (a==L"--weight" && i+1<argc){
+            std::string spec = w_to_u8(argv[++i]);
+            if (!set_source_weight(spec, '=')) dprintf("[source] bad --weight \"%s\" (want NAME=W)", spec.c_str());
+        }
+        else if (a==L"--lane-port" && i+1<argc){
+            std::string spec = w_to_u8(argv[++i]);
+            size_t eq = spec.find('=');
+            int lane = eq == std::string::npos ? -1 : lane_find(spec.substr(0, eq));
+            int port = lane < 0 ? 0 : atoi(spec.c_str() + eq + 1);
+            if (port > 0) g_lane_ports.push_back(ServerLanePort{ port, lane });
+            else dprintf("[lane] bad --lane-port \"%s\" (want alert|announce|chat=PORT)", spec.c_str());
+        }
         else if (a==L"--status-port" && i+1<argc) { g_status_port = _wtoi(argv[++i]); g_status_port_explicit = true; }
         else if (a==L"--devnum" && i+1<argc) g_dev_index = _wtoi(argv[++i]);
         else if (a==L"--posn-ms" && i+1<argc) g_posn_poll_ms = _wtoi(argv[++i]);
@@ -490,32 +1502,119 @@ else if (_wcsicmp(argv[i], L"--list-devices") == 0) {
     if (g_status_port < 0){
         g_status_port = g_port + 1;
     }
+    vox_cache_set_limits((size_t)g_vox_cache_entries, 1u << 20);
+    server_set_lane_ports(g_lane_ports);
+    dedupe_configure((uint32_t)g_dedupe_ms, g_dedupe_count);
+}
+
+// --rulepack: map the packs; the first one that loads becomes the default
+static void load_rulepacks(){
+    bool first = true;
+    for (const std::wstring& path : g_rulepacks){
+        std::string name; std::wstring err;
+        if (!vox_rulepack_load(path, name, err)){
+            dprintf("[pack] %s", w_to_u8(err).c_str());
+            continue;
+        }
+        if (first) vox_rulepack_select(name);
+        first = false;
+        dprintf("[pack] loaded \"%s\"", name.c_str());
+    }
+}
+
+// --lexicon: compile the user lexicon (a bad file only disables it)
+static void load_lexicon(){
+    if (g_lexicon_path.empty()) return;
+    std::wstring err;
+    if (lexicon_load(g_lexicon_path, err)) dprintf("[lexicon] %s", lexicon_describe(*lexicon_current()).c_str());
+    else dprintf("[lexicon] %s", w_to_u8(err).c_str());
+}
+
+// --templates: compile the announcement templates once, before the first message
+static void load_templates_at_start(){
+    if (g_templates_path.empty()) return;
+    std::wstring err;
+    if (load_templates(err)) dprintf("[tmpl] %s", templates_describe(*templates_current()).c_str());
+    else dprintf("[tmpl] %s", w_to_u8(err).c_str());
+}
+
+// --vox-batch: offline transform of a whole file, no engine or window needed
+static int run_vox_batch(){
+    VoxBatchStats st; std::wstring err;
+    DWORD t0 = GetTickCount();
+    VoxPackRef pack = vox_rulepack_get(std::string());
+    if (!vox_batch_file(g_vox_batch_in, g_vox_batch_out, !g_vox_clean, &pack->rules, lexicon_current().get(),
+                        g_sanitize, g_vox_batch_threads, st, err)){
+        dprintf("[batch] %s", w_to_u8(err).c_str());
+        return 1;
+    }
+    dprintf("[batch] %lu lines, %lu sentences, %lu -> %lu bytes, %d threads, %lu ms",
+            (unsigned long)st.lines, (unsigned long)st.sentences, (unsigned long)st.in_bytes,
+            (unsigned long)st.out_bytes, st.threads, (unsigned long)(GetTickCount() - t0));
+    return 0;
 }
 
 // ------------------------------------------------------------------
-// WinMain
-int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, PWSTR, int){
-    INITCOMMONCONTROLSEX icc{sizeof(icc), ICC_WIN95_CLASSES | ICC_LINK_CLASS};
-    if (!InitCommonControlsEx(&icc)){
-        icc.dwICC = ICC_WIN95_CLASSES;
-        InitCommonControlsEx(&icc);
+// Speech thread: owns g_hwnd (WndProc), the queue, the VOX encoder and the SAPI engine, in its
+// own COM apartment with its own message loop. The GUI dialog runs on the main thread and
+// only posts to g_hwnd, so a slow repaint or a modal box never delays the next kick_if_idle().
+struct SpeechThreadStart {
+    HINSTANCE inst;
+    HANDLE    ready;          // set once the engine is up (or failed)
+    DWORD     main_thread;    // gets WM_QUIT when this thread ends
+    bool      ok;
+    bool      started;        // --startserver succeeded
+};
+
+// Runs the speech thread once its window and engine are up: servers, timers, the message
+// loop. Returns the thread to post WM_QUIT to; speech_thread() does the engine/COM cleanup.
+static DWORD speech_thread_run(SpeechThreadStart* st){
+    tts_set_notify_hwnd(g_eng, g_hwnd);
+
+    bool started = false;
+    if (g_runserver){
+        started = server_start(g_host, g_port, g_hwnd);
+        if (started){
+            started = status_server_start(g_host, g_status_port);
+            if (!started){
+                server_stop();
+            }
+        }
     }
 
-    parse_cmdline();
+    if (g_posn_poll_ms > 0 && tts_supports_posn(g_eng)) start_posn_poll();
+    if (g_dedupe_count && dedupe_enabled()) g_dedupe_timer = SetTimer(g_hwnd, 43, 250, nullptr);
 
-    // Enumerate output devices once up front and reuse the cached mapping text.
-    // Helps avoid repeated WinMM queries when showing help or responding to flags.
-    (void)get_device_mapping_text();
+    const DWORD main_thread = st->main_thread;
+    st->started = started;
+    st->ok = true;
+    SetEvent(st->ready);          // `st` belongs to the main thread from here on
 
-    if (g_cli_help || (g_headless && !g_headless_noconsole)) log_attach_console();
-    log_set_verbose(g_headless && !g_headless_noconsole);
+    if (g_selftest){
+        enqueue_selftest();
+        kick_if_idle();
+        // literal (untagged) demo
+        std::wstring literal = L"Untagged literal: \\!sf30 should be spoken literally.";
+        (void)tts_speak(g_eng, literal, /*force_tagged*/false);
+    }
 
-    if (g_cli_help) {
-        show_help_and_exit(false);
-        return 0;
+    MSG msg;
+    while (GetMessageW(&msg, nullptr, 0, 0) > 0){
+        TranslateMessage(&msg);
+        DispatchMessageW(&msg);
     }
 
-    bool show_gui = !g_headless;
+    status_server_stop();
+    server_stop();
+    return main_thread;
+}
+
+static DWORD WINAPI speech_thread(LPVOID param){
+    auto* st = (SpeechThreadStart*)param;
+    HINSTANCE hInst = st->inst;
+    // the engine's apartment, joined once for the thread's life (tts_init may run again on a
+    // device change) and left on the one exit path below
+    const HRESULT com = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
 
     // Window
     WNDCLASSEXW wc{sizeof(wc)};
@@ -534,9 +1633,91 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, PWSTR, int){
                              nullptr, nullptr, hInst, nullptr);
     ShowWindow(g_hwnd, SW_HIDE);
 
+    const bool ok = SUCCEEDED(com) && g_hwnd && tts_init(g_eng, g_dev_index);
+    DWORD main_thread = 0;
+    if (ok) main_thread = speech_thread_run(st);
+    else if (g_hwnd) DestroyWindow(g_hwnd);
+
+    tts_shutdown(g_eng);
+    if (SUCCEEDED(com)) CoUninitialize();
+    if (!ok){
+        SetEvent(st->ready);      // st->ok stays false; the apartment is already gone
+        return 2;
+    }
+    PostThreadMessageW(main_thread, WM_QUIT, 0, 0);
+    return 0;
+}
+
+// ------------------------------------------------------------------
+// WinMain
+int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, PWSTR, int){
+    INITCOMMONCONTROLSEX icc{sizeof(icc), ICC_WIN95_CLASSES | ICC_LINK_CLASS};
+    if (!InitCommonControlsEx(&icc)){
+        icc.dwICC = ICC_WIN95_CLASSES;
+        InitCommonControlsEx(&icc);
+    }
+
+    parse_cmdline();
+
+    // Enumerate output devices once up front and reuse the cached mapping text.
+    // Helps avoid repeated WinMM queries when showing help or responding to flags.
+    (void)get_device_mapping_text();
+
+    if (g_cli_help || (g_headless && !g_headless_noconsole)) log_attach_console();
+    log_set_verbose(g_headless && !g_headless_noconsole);
+
+    if (g_cli_help) {
+        show_help_and_exit(false);
+        return 0;
+    }
+
+    if (!g_compile_src.empty()){
+        if (!g_headless_noconsole) log_attach_console();
+        log_set_verbose(!g_headless_noconsole);
+        std::wstring err;
+        if (!vox_rulepack_compile_file(g_compile_src, g_compile_out, err)){
+            dprintf("[pack] %s", w_to_u8(err).c_str());
+            return 1;
+        }
+        dprintf("[pack] compiled %s", w_to_u8(g_compile_out).c_str());
+        return 0;
+    }
+
+    load_rulepacks();
+    load_lexicon();
+
+    if (!g_vox_batch_in.empty()){
+        if (!g_headless_noconsole) log_attach_console();
+        log_set_verbose(!g_headless_noconsole);
+        return run_vox_batch();
+    }
+    load_templates_at_start();
+
+    bool show_gui = !g_headless;
+
+    // Speech thread: window, engine, servers
+    MSG msg;
+    PeekMessageW(&msg, nullptr, WM_USER, WM_USER, PM_NOREMOVE);   // queue exists before the speech thread can post WM_QUIT
+    SpeechThreadStart st{ hInst, CreateEventW(nullptr, TRUE, FALSE, nullptr), GetCurrentThreadId(), false, false };
+    HANDLE speech = st.ready ? CreateThread(nullptr, 0, speech_thread, &st, 0, nullptr) : nullptr;
+    if (!speech){
+        MessageBeep(MB_ICONERROR);
+        return 2;
+    }
+    WaitForSingleObject(st.ready, INFINITE);
+    CloseHandle(st.ready);
+    if (!st.ok){
+        WaitForSingleObject(speech, INFINITE);
+        CloseHandle(speech);
+        MessageBeep(MB_ICONERROR);
+        return 2;
+    }
+
     HWND hDlg = nullptr;
     if (show_gui) {
-        hDlg = create_main_dialog(hInst, g_hwnd);
+        // no owner: an owner window on the speech thread would attach the two threads' input
+        // queues, and the dialog only ever posts to g_hwnd anyway
+        hDlg = create_main_dialog(hInst, nullptr);
         gui_set_app_hwnd(g_hwnd);
 
         if (hDlg){
@@ -547,7 +1728,7 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, PWSTR, int){
             f->port = g_port;
             PostMessageW(hDlg, WM_APP_SET_SERVER_FIELDS, 0, (LPARAM)f);
 
-            PostMessageW(hDlg, WM_APP_SERVER_STATE, server_is_running() ? 1 : 0, 0);
+            PostMessageW(hDlg, WM_APP_SERVER_STATE, st.started ? 1 : 0, 0);
 
             int mode = 0;
             if (g_vox_enabled) mode = g_vox_clean ? 2 : 1;
@@ -555,45 +1736,14 @@ int WINAPI wWinMain(HINSTANCE hInst, HINSTANCE, PWSTR, int){
         }
     }
 
-    if (!tts_init(g_eng, g_dev_index)){
-        MessageBeep(MB_ICONERROR);
-        return 2;
-    }
-    tts_set_notify_hwnd(g_eng, g_hwnd);
-
-    bool started = false;
-    if (g_runserver){
-        started = server_start(g_host, g_port, g_hwnd);
-        if (started){
-            started = status_server_start(g_host, g_status_port);
-            if (!started){
-                server_stop();
-            }
-        }
-    }
-    if (show_gui && hDlg){
-        PostMessageW(hDlg, WM_APP_SERVER_STATE, started ? 1 : 0, 0);
-    }
-
-    if (g_posn_poll_ms > 0 && tts_supports_posn(g_eng)) start_posn_poll();
-
-    if (g_selftest){
-        enqueue_selftest();
-        kick_if_idle();
-        // literal (untagged) demo
-        std::wstring literal = L"Untagged literal: \\!sf30 should be spoken literally.";
-        (void)tts_speak(g_eng, literal, /*force_tagged*/false);
-    }
-
-    MSG msg;
+    // GUI pump (or, headless, just a wait): ends when the dialog closes or the speech thread
+    // quits, then takes the other one down
     while (GetMessageW(&msg, nullptr, 0, 0) > 0){
         TranslateMessage(&msg);
         DispatchMessageW(&msg);
     }
-
-    status_server_stop();
-    server_stop();
-    tts_shutdown(g_eng);
-    CoUninitialize();
+    PostMessageW(g_hwnd, WM_CLOSE, 0, 0);
+    WaitForSingleObject(speech, 5000);
+    CloseHandle(speech);
     return 0;
 }
@@ -6,17 +6,12 @@
 
 #include "log.hpp"
 #include "net_server.hpp"
+#include "ingress.hpp"
 #include "util.hpp"
 #include <string>
 #include <atomic>
 #include <vector>
-
-#ifndef WM_APP
-#  define WM_APP 0x8000
-#endif
-#ifndef WM_APP_SPEAK
-#  define WM_APP_SPEAK (WM_APP+1)
-#endif
+#include <algorithm>
 
 static HANDLE g_hThread = nullptr;
 static volatile LONG g_stop = 0;
@@ -126,6 +121,87 @@ bool status_server_is_running(){
     return g_status_running.load(std::memory_order_acquire);
 }
 
+// Extra command ports (--lane-port); lines from them carry their lane as the ingress tag
+static std::vector<ServerLanePort> g_lane_ports;
+
+void server_set_lane_ports(const std::vector<ServerLanePort>& ports){
+    g_lane_ports = ports;
+}
+
+// Paused connection ids (sorted); the server thread copies them when the generation moves
+static std::vector<uint32_t> g_paused_ids;
+static std::atomic<unsigned> g_paused_gen{0};
+
+static CRITICAL_SECTION& paused_cs(){
+    static CRITICAL_SECTION cs;
+    static const bool init = (InitializeCriticalSection(&cs), true);
+    (void)init;
+    return cs;
+}
+
+void server_set_paused(std::vector<uint32_t> ids){
+    std::sort(ids.begin(), ids.end());
+    EnterCriticalSection(&paused_cs());
+    g_paused_ids.swap(ids);
+    LeaveCriticalSection(&paused_cs());
+    g_paused_gen.fetch_add(1, std::memory_order_release);
+}
+
+struct CmdListener { SOCKET s; int port; WPARAM tag; };
+struct CmdClient {
+    SOCKET      s;
+    WPARAM      tag;
+    uint32_t    id;              // the source of its lines
+    std::string buf;
+    bool        blocked = false; // the ring was full: buf holds lines still to queue, not read meanwhile
+    bool        closed  = false; // gone (s closed); stays until its close record is queued
+};
+
+// Moves the complete lines in c.buf into the ingress ring, then the close record once the
+// connection is gone. A full ring leaves the rest in c.buf and marks the client blocked, so
+// the server thread keeps serving everyone else and retries it on the next pass instead of
+// waiting here. false = blocked.
+static bool flush_client(CmdClient& c){
+    size_t start = 0, pos;
+    bool ok = true;
+    while((pos = c.buf.find('\n', start)) != std::string::npos){
+        size_t len = pos - start;
+        if(len && c.buf[start + len - 1]=='\r') --len;
+        // (blocked: this first line is the one the ring refused last time)
+        if (!ingress_push(c.buf.data() + start, len, (int)c.tag, c.id, c.blocked && !start)){ ok = false; break; }
+        start = pos + 1;
+    }
+    c.buf.erase(0, start);
+    if (ok && c.closed) ok = ingress_push("", 0, -1, c.id, c.blocked && !start);
+    c.blocked = !ok;
+    return ok;
+}
+
+static SOCKET open_listener(sockaddr_in addr, int port, const std::string& hostA){
+    addr.sin_port = htons( (u_short)port );
+    SOCKET s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if(s==INVALID_SOCKET){
+        dprintf("[net] socket() failed");
+        return INVALID_SOCKET;
+    }
+    int opt=1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
+    if(bind(s,(sockaddr*)&addr,sizeof(addr))==SOCKET_ERROR){
+        dprintf("[net] bind() failed on port %d", port);
+        closesocket(s);
+        return INVALID_SOCKET;
+    }
+    if(listen(s, 4)==SOCKET_ERROR){
+        dprintf("[net] listen() failed on port %d", port);
+        closesocket(s);
+        return INVALID_SOCKET;
+    }
+    dprintf("[net] listening on %s:%d", hostA.c_str(), port);
+    return s;
+}
+
+// One thread serves every command port and every client with select(), so a client on an
+// alert port is heard while a chat client stays connected.
 static DWORD WINAPI server_thread(LPVOID){
     WSADATA wsa; 
     if (WSAStartup(MAKEWORD(2,2), &wsa) != 0) {
@@ -135,7 +211,6 @@ static DWORD WINAPI server_thread(LPVOID){
 
     sockaddr_in addr{}; 
     addr.sin_family = AF_INET; 
-    addr.sin_port   = htons( (u_short)g_port );
 
     std::string hostA = w_to_u8(g_host);
     if (!parse_ipv4(hostA, &addr.sin_addr)) {
@@ -145,62 +220,97 @@ static DWORD WINAPI server_thread(LPVOID){
         }
     }
 
-    g_listen = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    if(g_listen==INVALID_SOCKET){ 
-        dprintf("[net] socket() failed"); 
+    g_listen = open_listener(addr, g_port, hostA);
+    if(g_listen==INVALID_SOCKET){
         WSACleanup();
-        return 0; 
-    }
-
-    int opt=1; 
-    setsockopt(g_listen, SOL_SOCKET, SO_REUSEADDR, (char*)&opt, sizeof(opt));
-
-    if(bind(g_listen,(sockaddr*)&addr,sizeof(addr))==SOCKET_ERROR){ 
-        dprintf("[net] bind() failed"); 
-        closesocket(g_listen); g_listen=INVALID_SOCKET; 
-        WSACleanup(); 
-        return 0; 
+        return 0;
     }
-    if(listen(g_listen, 4)==SOCKET_ERROR){ 
-        dprintf("[net] listen() failed"); 
-        closesocket(g_listen); g_listen=INVALID_SOCKET; 
-        WSACleanup(); 
-        return 0; 
+    std::vector<CmdListener> listeners;
+    listeners.push_back(CmdListener{ g_listen, g_port, 0 });
+    for (const ServerLanePort& lp : g_lane_ports){
+        SOCKET s = open_listener(addr, lp.port, hostA);
+        if (s != INVALID_SOCKET) listeners.push_back(CmdListener{ s, lp.port, (WPARAM)(lp.lane + 1) });
     }
     g_server_running.store(true, std::memory_order_release);
-    dprintf("[net] listening on %s:%d", hostA.c_str(), g_port);
 
+    std::vector<CmdClient> clients;
+    uint32_t next_id = 0;
+    std::vector<uint32_t> paused;
+    unsigned paused_gen = g_paused_gen.load(std::memory_order_acquire) - 1;
+    char tmp[512];
     while(!g_stop){
-        fd_set rf; FD_ZERO(&rf); FD_SET(g_listen, &rf);
-        timeval tv{0, 200*1000};
+        bool blocked = false;
+        for (size_t i = 0; i < clients.size(); ){
+            CmdClient& c = clients[i];
+            if (c.blocked && flush_client(c) && c.closed){
+                dprintf("[net] client %u disconnected", c.id);
+                clients.erase(clients.begin() + i);
+                continue;
+            }
+            blocked |= c.blocked;
+            ++i;
+        }
+        fd_set rf; FD_ZERO(&rf);
+        for (const CmdListener& l : listeners) FD_SET(l.s, &rf);
+        // a paused client is left unread (not even selected); poll faster to resume promptly
+        const unsigned gen = g_paused_gen.load(std::memory_order_acquire);
+        if (gen != paused_gen){
+            EnterCriticalSection(&paused_cs());
+            paused = g_paused_ids;
+            LeaveCriticalSection(&paused_cs());
+            paused_gen = gen;
+        }
+        // (nor is a blocked one, retried soon)
+        for (const CmdClient& c : clients)
+            if (!c.blocked && !std::binary_search(paused.begin(), paused.end(), c.id)) FD_SET(c.s, &rf);
+        timeval tv{0, (blocked ? 10 : paused.empty() ? 200 : 50)*1000};
         int r = select(0, &rf, nullptr, nullptr, &tv);
         if(r<=0){ continue; }
-        sockaddr_in cli; int clen=sizeof(cli);
-        SOCKET s = accept(g_listen,(sockaddr*)&cli,&clen);
-        if(s==INVALID_SOCKET) continue;
-        configure_keepalive(s);
-        dprintf("[net] client connected");
-
-        std::string buf; buf.reserve(1024);
-        char tmp[512];
-        for(;;){
-            int n = recv(s,tmp,sizeof(tmp),0);
-            if(n<=0) break;
-            buf.append(tmp, tmp+n);
-            size_t pos;
-            while((pos = buf.find('\n')) != std::string::npos){
-                std::string line = buf.substr(0,pos);
-                buf.erase(0,pos+1);
-                if(!line.empty() && line.back()=='\r') line.pop_back();
-                std::string* heap = new std::string(std::move(line));
-                PostMessageW(g_hwnd, WM_APP_SPEAK, 0, (LPARAM)heap);
+
+        for (const CmdListener& l : listeners){
+            if (!FD_ISSET(l.s, &rf)) continue;
+            sockaddr_in cli; int clen=sizeof(cli);
+            SOCKET s = accept(l.s,(sockaddr*)&cli,&clen);
+            if(s==INVALID_SOCKET) continue;
+            if (listeners.size() + clients.size() >= FD_SETSIZE){
+                dprintf("[net] too many clients; closing new connection on port %d", l.port);
+                closesocket(s);
+                continue;
             }
+            configure_keepalive(s);
+            if (++next_id == 0) ++next_id;   // 0 is the local source
+            clients.push_back(CmdClient{ s, l.tag, next_id, std::string() });
+            dprintf("[net] client %u connected on port %d", next_id, l.port);
+        }
+
+        for (size_t i = 0; i < clients.size(); ){
+            CmdClient& c = clients[i];
+            if (c.blocked || !FD_ISSET(c.s, &rf)){ ++i; continue; }
+            int n = recv(c.s,tmp,sizeof(tmp),0);
+            if(n<=0){
+                closesocket(c.s);
+                c.s = INVALID_SOCKET;
+                c.closed = true;
+                c.buf.clear();   // an unterminated last line is dropped
+                if (flush_client(c)){
+                    dprintf("[net] client %u disconnected", c.id);
+                    clients.erase(clients.begin() + i);
+                    continue;
+                }
+                ++i;
+                continue;
+            }
+            // lines go straight from the receive buffer into the ingress ring; while it is
+            // full this client alone stops being read, so its TCP window pushes back on it
+            c.buf.append(tmp, tmp+n);
+            flush_client(c);
+            ++i;
         }
-        closesocket(s);
-        dprintf("[net] client disconnected");
     }
 
-    if(g_listen!=INVALID_SOCKET){ closesocket(g_listen); g_listen=INVALID_SOCKET; }
+    for (const CmdClient& c : clients) if (c.s != INVALID_SOCKET) closesocket(c.s);
+    for (const CmdListener& l : listeners) closesocket(l.s);
+    g_listen=INVALID_SOCKET;
     WSACleanup();
     return 0;
 }
@@ -281,6 +391,10 @@ static DWORD WINAPI status_server_thread(LPVOID){
             SOCKET s = accept(g_status_listen,(sockaddr*)&cli,&clen);
             if(s!=INVALID_SOCKET){
                 configure_keepalive(s);
+                // non-blocking: a client that stops reading is dropped by the next broadcast
+                // instead of stalling the speech thread inside send()
+                u_long nb = 1;
+                ioctlsocket(s, FIONBIO, &nb);
                 if (g_status_cs_init) EnterCriticalSection(&g_status_cs);
                 g_status_clients.push_back(s);
                 if (g_status_cs_init) LeaveCriticalSection(&g_status_cs);
@@ -318,6 +432,7 @@ static DWORD WINAPI status_server_thread(LPVOID){
 bool server_start(const std::wstring& host, int port, HWND hwnd){
     if(g_hThread) return true;
     g_stop=0; g_hwnd=hwnd; g_host=host; g_port=port;
+    ingress_set_target(hwnd);
     g_hThread = CreateThread(nullptr,0,server_thread,nullptr,0,nullptr);
 
     return g_hThread!=nullptr;
@@ -369,10 +484,13 @@ void status_server_broadcast(const char* msg, size_t len){
     if (g_status_cs_init) EnterCriticalSection(&g_status_cs);
     for (size_t i = 0; i < g_status_clients.size(); ){
         SOCKET s = g_status_clients[i];
+        // a short send would leave a cut-off record for the next line to run into, so a
+        // client whose buffer cannot take the whole line is dropped like a dead one
         int sent = send(s, msg, (int)len, 0);
-        if (sent <= 0){
+        if (sent != (int)len){
             status_remove_client_locked(g_status_clients, i);
-            dprintf("[status] client disconnected");
+            if (sent > 0) dprintf("[status] client not keeping up; disconnected");
+            else dprintf("[status] client disconnected");
             continue;
         }
         ++i;
@@ -1,8 +1,17 @@
 #pragma once
 #include <windows.h>
 #include <string>
+#include <vector>
 
 bool server_start(const std::wstring& host, int port, HWND hwnd);
+// Extra command ports that tag their lines with a queue lane: the ingress tag is lane + 1
+// (0 = the main port). Takes effect at the next server_start().
+struct ServerLanePort { int port; int lane; };
+void server_set_lane_ports(const std::vector<ServerLanePort>& ports);
+// Backpressure: the connections in `ids` (the source ids their lines carry through the
+// ingress ring) are not read from until a later call leaves them out; their TCP windows
+// fill and those producers block while everyone else keeps going. Any thread.
+void server_set_paused(std::vector<uint32_t> ids);
 void server_stop();
 
 bool server_is_running();  // returns true iff the TCP server is currently active
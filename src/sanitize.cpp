@@ -0,0 +1,158 @@
+#include "sanitize.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+constexpr char   kLink[]  = "link";              // shorter than any URL it replaces
+constexpr size_t kLinkLen = sizeof(kLink) - 1;
+constexpr int    kMaxPunctRun = 3;
+
+// Code points FlexTalk cannot say (it spells them, reads a code or stalls), sorted. `gap`:
+// the character stood for something (a symbol, an emoji), so it separates words like a
+// space; otherwise it vanishes (marks and invisible formatting characters).
+struct CpRange { uint32_t lo, hi; bool gap; };
+constexpr CpRange kDrop[] = {
+    { 0x0080, 0x009F, true  },   // C1 controls
+    { 0x0300, 0x036F, false },   // combining diacritics ("zalgo")
+    { 0x1AB0, 0x1AFF, false }, { 0x1DC0, 0x1DFF, false },
+    { 0x200B, 0x200F, false },   // zero width, LRM/RLM
+    { 0x202A, 0x202E, false }, { 0x2060, 0x206F, false },
+    { 0x20D0, 0x20FF, false },   // combining marks for symbols
+    { 0x2190, 0x21FF, true  },   // arrows
+    { 0x2300, 0x23FF, true  },   // misc technical (watch, hourglass...)
+    { 0x2460, 0x24FF, true  },   // enclosed alphanumerics
+    { 0x2500, 0x27BF, true  },   // box drawing, shapes, misc symbols, dingbats
+    { 0x2900, 0x297F, true  }, { 0x2B00, 0x2BFF, true },
+    { 0x3030, 0x3030, true  }, { 0x303D, 0x303D, true }, { 0x3297, 0x3297, true }, { 0x3299, 0x3299, true },
+    { 0xE000, 0xF8FF, true  },   // private use
+    { 0xFE00, 0xFE0F, false },   // variation selectors
+    { 0xFE20, 0xFE2F, false },
+    { 0xFEFF, 0xFEFF, false },   // BOM / ZWNBSP
+    { 0xFFF0, 0xFFFF, true  },   // specials, U+FFFD
+    { 0x1F000, 0x1FAFF, true },  // emoji and pictographs (skin tones included)
+    { 0xE0000, 0xE01EF, false }, // tags, variation selectors supplement
+    { 0xF0000, 0x10FFFF, true }, // supplementary private use
+};
+
+// 0 = keep, 1 = drop silently, 2 = drop as a word gap
+int drop_cp(uint32_t cp){
+    if (cp < 0x80) return (cp < 0x20 || cp == 0x7F) ? 2 : 0;
+    const CpRange* e = kDrop + sizeof(kDrop) / sizeof(kDrop[0]);
+    const CpRange* r = std::upper_bound(kDrop, e, cp, [](uint32_t v, const CpRange& x){ return v < x.lo; });
+    if (r == kDrop || cp > r[-1].hi) return 0;
+    return r[-1].gap ? 2 : 1;
+}
+
+// Decodes one UTF-8 sequence at s[i]; 0 = invalid (overlong, surrogate, truncated).
+size_t decode(const std::string& s, size_t i, uint32_t& cp){
+    const unsigned char c = (unsigned char)s[i];
+    size_t k; uint32_t min;
+    if (c < 0x80){ cp = c; return 1; }
+    if      ((c & 0xE0) == 0xC0){ k = 2; cp = c & 0x1F; min = 0x80; }
+    else if ((c & 0xF0) == 0xE0){ k = 3; cp = c & 0x0F; min = 0x800; }
+    else if ((c & 0xF8) == 0xF0){ k = 4; cp = c & 0x07; min = 0x10000; }
+    else return 0;
+    if (i + k > s.size()) return 0;
+    for (size_t j = 1; j < k; ++j){
+        const unsigned char d = (unsigned char)s[i + j];
+        if ((d & 0xC0) != 0x80) return 0;
+        cp = (cp << 6) | (d & 0x3F);
+    }
+    if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) return 0;
+    return k;
+}
+
+inline bool ascii_space(unsigned char c){ return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+// Length of the URL starting at s[i] (0 = none); trailing sentence punctuation stays out.
+size_t url_at(const std::string& s, size_t i){
+    auto starts = [&](const char* p){
+        size_t k = 0;
+        for (; p[k]; ++k) if (i + k >= s.size() || tolower((unsigned char)s[i + k]) != p[k]) return (size_t)0;
+        return k;
+    };
+    size_t k = starts("https://");
+    if (!k) k = starts("http://");
+    if (!k) k = starts("www.");
+    if (!k || i + k >= s.size() || ascii_space((unsigned char)s[i + k])) return 0;
+    size_t e = i + k;
+    while (e < s.size() && !ascii_space((unsigned char)s[e])) ++e;
+    while (e > i + k && strchr(".,;:!?)]>'\"", s[e - 1])) --e;
+    return e - i;
+}
+
+enum Kind { K_LETTER, K_DIGIT, K_PUNCT };
+
+Kind kind_of(uint32_t cp){
+    if (cp < 0x80){
+        if (isalpha((int)cp)) return K_LETTER;
+        if (isdigit((int)cp)) return K_DIGIT;
+        return K_PUNCT;
+    }
+    // general punctuation (dashes, quotes, ellipsis), Latin-1 symbols and CJK punctuation
+    if ((cp >= 0x2000 && cp <= 0x206F) || (cp >= 0xA1 && cp <= 0xBF) || (cp >= 0x3000 && cp <= 0x303F)) return K_PUNCT;
+    return K_LETTER;
+}
+
+int repeat_limit(uint32_t cp, Kind k){
+    if (k == K_DIGIT) return 0x7FFFFFFF;
+    if (k == K_LETTER) return 2;
+    if (cp == '.') return 3;
+    if (cp == '[' || cp == ']') return 2;
+    return 1;
+}
+
+} // namespace
+
+bool chat_sanitize(std::string& s, SanitizeStats* st){
+    SanitizeStats local;
+    SanitizeStats& S = st ? *st : local;
+    const size_t n = s.size();
+    size_t r = 0, w = 0;
+    uint32_t prev = 0;        // last code point written
+    int run = 0, punct = 0;   // copies of `prev` in a row; punctuation marks in a row
+    bool space = true;        // last thing written was a space (or nothing yet)
+    bool retyped = false;     // a tab/newline became a space in place (every other change shrinks)
+
+    while (r < n){
+        const unsigned char c = (unsigned char)s[r];
+        if (ascii_space(c)){
+            if (!space){ retyped |= (c != ' '); s[w++] = ' '; space = true; }
+            ++r; prev = ' '; run = 0; punct = 0;
+            continue;
+        }
+        if (space || prev == '(' || prev == '<' || prev == '"'){
+            if (size_t u = url_at(s, r)){
+                for (size_t k = 0; k < kLinkLen; ++k) s[w + k] = kLink[k];   // w + 4 <= r + u
+                w += kLinkLen; r += u;
+                prev = 0; run = 0; punct = 0; space = false;
+                ++S.urls;
+                continue;
+            }
+        }
+        uint32_t cp;
+        size_t k = decode(s, r, cp);
+        const int drop = k ? drop_cp(cp) : 2;
+        if (drop){
+            r += k ? k : 1;
+            ++S.dropped;
+            if (drop == 2 && !space){ s[w++] = ' '; space = true; prev = ' '; run = 0; punct = 0; }
+            continue;
+        }
+        const Kind kind = kind_of(cp);
+        run = (cp == prev) ? run + 1 : 1;
+        if (run > repeat_limit(cp, kind)){ r += k; ++S.repeats; continue; }
+        if (kind == K_PUNCT){
+            if (++punct > kMaxPunctRun){ r += k; ++S.repeats; continue; }
+        } else punct = 0;
+        if (w != r) for (size_t j = 0; j < k; ++j) s[w + j] = s[r + j];
+        w += k; r += k;
+        prev = cp; space = false;
+    }
+    if (w > 0 && s[w - 1] == ' ') --w;
+    if (w == n) return retyped;
+    s.resize(w);
+    return true;
+}
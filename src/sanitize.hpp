@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Chat clean-up before TTS, in one in-place scan over UTF-8 (never allocates; the text only
+// shrinks):
+// - URLs (http://, https://, www.) become the word "link"
+// - a letter repeated 3+ times keeps two ("lollllll" -> "loll"), a punctuation mark keeps
+//   one ("!!!!" -> "!"; "..." and the "[[" / "]]" of inline directives survive), and a run
+//   of mixed punctuation keeps its first three marks
+// - emoji, pictographs, combining marks, control and zero-width characters, private-use
+//   code points and invalid UTF-8 are dropped
+// - whitespace runs become one space; leading and trailing whitespace goes
+struct SanitizeStats {
+    uint32_t urls     = 0;   // URLs replaced
+    uint32_t repeats  = 0;   // characters removed by collapsing runs
+    uint32_t dropped  = 0;   // code points (or invalid bytes) stripped
+};
+
+// Returns true when `text` changed; `st` (optional) is added to.
+bool chat_sanitize(std::string& text, SanitizeStats* st = nullptr);
@@ -0,0 +1,119 @@
+#include "speech_time.hpp"
+#include "vox_parser.hpp"
+#include <cwctype>
+#include <algorithm>
+
+namespace {
+
+// Starting point for FlexTalk at \!R1.00; the calibration factor corrects both.
+constexpr double kMsPerSyllable = 210.0;
+constexpr double kMsPerBreak    = 120.0;
+// Runs shorter than this are mostly engine latency and would skew the factor.
+constexpr double kMinSampleMs   = 800.0;
+constexpr double kAlpha         = 0.2;
+
+double   g_scale   = 1.0;
+double   g_error   = 0.0;
+uint32_t g_samples = 0;
+
+// \!R scale of the rate slider: smaller is faster (the engine clamps very small values).
+inline double rate_scale(int rate_pct){ return std::max(30, std::min(rate_pct, 200)) / 100.0; }
+
+inline double model_ms(const SpeechCost& c, int rate_pct){
+    return rate_scale(rate_pct) * (c.syllables * kMsPerSyllable + c.breaks * kMsPerBreak);
+}
+
+// Walks `text` item by item (tag or word), adding each one's cost to `c`. `stop` is asked
+// before every word; returning true ends the walk there.
+template <class Stop>
+size_t walk(const std::wstring& text, SpeechCost& c, Stop stop){
+    const size_t n = text.size();
+    size_t i = 0;
+    while (i < n){
+        if (iswspace(text[i])){ ++i; continue; }
+        if (text[i] == L'\\' && i + 1 < n && text[i + 1] == L'!'){
+            size_t t = i + 2, e = t;
+            while (e < n && !iswspace(text[e]) && text[e] != L'\\') ++e;
+            if (e - t >= 2 && text[t] == L'b' && text[t + 1] == L'r') ++c.breaks;
+            else if (e - t >= 3 && text[t] == L's' && (text[t + 1] == L'f' || text[t + 1] == L'i')){
+                unsigned v = 0;
+                for (size_t k = t + 2; k < e && iswdigit(text[k]); ++k) v = std::min(v * 10 + (text[k] - L'0'), 99999u);
+                c.pause_cs += v;
+            }
+            i = e;
+            continue;
+        }
+        size_t e = i;
+        while (e < n && !iswspace(text[e]) && !(text[e] == L'\\' && e + 1 < n && text[e + 1] == L'!')) ++e;
+        if (stop(i, c)) return i;
+        // letters by the encoder's heuristic, digit runs at ~1.5 syllables a digit
+        for (size_t k = i; k < e; ){
+            size_t r = k;
+            if (iswdigit(text[k])){
+                while (r < e && iswdigit(text[r])) ++r;
+                c.syllables += (uint32_t)((r - k) * 3 + 1) / 2;
+            } else if (iswalpha(text[k])){
+                while (r < e && iswalpha(text[r])) ++r;
+                c.syllables += (uint32_t)vox_syllables(text.data() + k, r - k);
+            } else r = k + 1;
+            k = r;
+        }
+        i = e;
+    }
+    return n;
+}
+
+} // namespace
+
+SpeechCost speech_cost(const std::wstring& text){
+    SpeechCost c;
+    walk(text, c, [](size_t, const SpeechCost&){ return false; });
+    return c;
+}
+
+double speech_estimate_ms(const SpeechCost& c, int rate_pct){
+    return g_scale * model_ms(c, rate_pct) + c.pause_cs * 10.0;
+}
+
+bool speech_trim(std::wstring& text, double budget_ms, int rate_pct){
+    // `stop` sees the cost of everything before each word: keep the last start that still
+    // fits, and stop at the first word that is already past the budget.
+    SpeechCost c;
+    size_t last = 0;
+    walk(text, c, [&](size_t at, const SpeechCost& sofar){
+        if (speech_estimate_ms(sofar, rate_pct) > budget_ms) return true;
+        last = at;
+        return false;
+    });
+    if (speech_estimate_ms(c, rate_pct) <= budget_ms) return false;
+    const bool wrapped = text.rfind(L"\\!wH1", last) != std::wstring::npos;
+    text.erase(last);
+    while (!text.empty() && iswspace(text.back())) text.pop_back();
+    if (wrapped) text += L" \\!wH0 ";
+    return true;
+}
+
+void speech_run_add(SpeechRun& run, const SpeechCost& c, int rate_pct){
+    run.model_ms += model_ms(c, rate_pct);
+    run.pause_ms += c.pause_cs * 10.0;
+    ++run.chunks;
+}
+
+double speech_run_estimate_ms(const SpeechRun& run){
+    return g_scale * run.model_ms + run.pause_ms;
+}
+
+void speech_calibrate(const SpeechRun& run, double measured_ms){
+    if (run.model_ms < kMinSampleMs || measured_ms <= run.pause_ms) return;
+    const double est = speech_run_estimate_ms(run);
+    const double ratio = std::max(0.25, std::min((measured_ms - run.pause_ms) / run.model_ms, 4.0));
+    const double err = (est > measured_ms ? est - measured_ms : measured_ms - est) / measured_ms;
+    // the first sample replaces the built-in guess outright
+    g_scale = g_samples ? g_scale + kAlpha * (ratio - g_scale) : ratio;
+    g_error = g_samples ? g_error + kAlpha * (err - g_error) : err;
+    ++g_samples;
+}
+
+SpeechModelStats speech_model_stats(){
+    return SpeechModelStats{ g_scale, g_error, g_samples };
+}
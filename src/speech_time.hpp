@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Spoken-duration estimates for queued chunks, used for the --max-msg-seconds and
+// --max-queue-seconds budgets and the per-message ETA.
+//
+// A chunk costs its syllables (the VOX encoder's heuristic), its \!br boundaries and its
+// explicit \!sf/\!si pauses. Syllables and boundaries scale with the \!R rate the chunk is
+// spoken at; the result is multiplied by one factor that tracks measured
+// TextDataStarted -> AudioStop times (speech_calibrate). UI thread only.
+struct SpeechCost {
+    uint32_t syllables = 0;
+    uint32_t breaks    = 0;
+    uint32_t pause_cs  = 0;
+};
+
+SpeechCost speech_cost(const std::wstring& text);
+double     speech_estimate_ms(const SpeechCost& c, int rate_pct);
+
+// Cuts `text` at the last word boundary that fits in `budget_ms` (closing an open \!wH1).
+// Returns false when the whole text fits; `text` is then untouched.
+bool speech_trim(std::wstring& text, double budget_ms, int rate_pct);
+
+// A stretch of chunks spoken back to back, from the first TextDataStarted to AudioStop.
+struct SpeechRun {
+    double   model_ms = 0;    // syllables + boundaries at the rates used, before calibration
+    double   pause_ms = 0;
+    uint32_t chunks   = 0;
+};
+void   speech_run_add(SpeechRun& run, const SpeechCost& c, int rate_pct);
+double speech_run_estimate_ms(const SpeechRun& run);
+void   speech_calibrate(const SpeechRun& run, double measured_ms);
+
+struct SpeechModelStats {
+    double   scale;           // measured / model, smoothed
+    double   error;           // smoothed |estimate - measured| / measured
+    uint32_t samples;
+};
+SpeechModelStats speech_model_stats();
@@ -0,0 +1,274 @@
+#include "templates.hpp"
+#include "lexicon.hpp"
+#include "vox_parser.hpp"
+#include "util.hpp"
+#include <windows.h>
+#include <atomic>
+#include <cstdio>
+#include <cctype>
+
+namespace {
+
+struct Template {
+    std::string name;
+    std::vector<std::string>  slots;   // distinct slot names, in order of first use
+    std::vector<std::wstring> text;    // literal pieces around the slots (refs.size() + 1)
+    std::vector<uint16_t>     refs;    // slot index between text[i] and text[i+1]
+};
+
+// Stand-in word for slot i while the template goes through the encoder: lowercase letters
+// only, so no rule (numbers, title-case runs, letter tokens) touches it.
+constexpr char   kMark[] = "zqslot";
+constexpr size_t kMarkLen = sizeof(kMark) - 1;
+constexpr size_t kMaxSlots = 26 * 26;
+
+inline bool name_char(unsigned char c){ return c == '_' || c == '-' || isalnum(c); }
+inline bool key_char(unsigned char c){ return c == '_' || isalnum(c); }
+
+void trim(std::string& s){
+    while (!s.empty() && isspace((unsigned char)s.back())) s.pop_back();
+    size_t b = 0; while (b < s.size() && isspace((unsigned char)s[b])) ++b;
+    s.erase(0, b);
+}
+
+std::wstring win_error(const wchar_t* what, const std::wstring& path){
+    wchar_t buf[64]; _snwprintf(buf, 63, L" (error %lu)", GetLastError()); buf[63] = 0;
+    return std::wstring(what) + L" " + path + buf;
+}
+
+// "{slot}" -> marker word; fills t.slots.
+bool mark_slots(const std::string& body, Template& t, std::string& marked, const char*& why){
+    marked.clear();
+    for (size_t i = 0; i < body.size(); ){
+        if (body[i] != '{'){ marked.push_back(body[i++]); continue; }
+        size_t e = i + 1;
+        while (e < body.size() && key_char((unsigned char)body[e])) ++e;
+        if (e == i + 1 || e >= body.size() || body[e] != '}'){ why = "slot must be {name} (letters, digits, _)"; return false; }
+        std::string key = body.substr(i + 1, e - i - 1);
+        size_t k = 0;
+        while (k < t.slots.size() && t.slots[k] != key) ++k;
+        if (k == t.slots.size()){
+            if (k == kMaxSlots){ why = "too many slots"; return false; }
+            t.slots.push_back(key);
+        }
+        marked += kMark;
+        marked.push_back((char)('a' + k / 26));
+        marked.push_back((char)('a' + k % 26));
+        i = e + 1;
+    }
+    return true;
+}
+
+// Encoded text -> literal pieces and slot references; every marker has to come through intact.
+bool split_marks(const std::wstring& enc, size_t expect, Template& t){
+    const std::wstring mark(kMark, kMark + kMarkLen);
+    size_t at = 0;
+    for (size_t p; (p = enc.find(mark, at)) != std::wstring::npos; ){
+        size_t q = p + kMarkLen;
+        if (q + 2 > enc.size()) return false;
+        unsigned k = (unsigned)(enc[q] - L'a') * 26 + (unsigned)(enc[q + 1] - L'a');
+        if (enc[q] < L'a' || enc[q] > L'z' || enc[q + 1] < L'a' || enc[q + 1] > L'z' || k >= t.slots.size()) return false;
+        t.text.push_back(enc.substr(at, p - at));
+        t.refs.push_back((uint16_t)k);
+        at = q + 2;
+    }
+    t.text.push_back(enc.substr(at));
+    return t.refs.size() == expect;
+}
+
+} // namespace
+
+struct TemplateSet {
+    std::wstring path;
+    bool vox = false, wrap = true;
+    VoxPackRef pack;                   // slot values are encoded with the rules the text was
+    std::vector<Template> list;
+};
+
+namespace {
+
+TemplateSetRef g_current;
+
+bool parse_templates(const std::string& text, TemplateSet& set, const Lexicon* lexicon, std::string& err){
+    size_t pos = 0, lineno = 0;
+    auto fail = [&](const char* what){
+        char buf[160]; snprintf(buf, sizeof(buf), "line %u: %s", (unsigned)lineno, what);
+        err = buf; return false;
+    };
+    std::string marked;
+    while (pos < text.size()){
+        size_t nl = text.find('\n', pos);
+        std::string line = text.substr(pos, nl == std::string::npos ? std::string::npos : nl - pos);
+        pos = (nl == std::string::npos) ? text.size() : nl + 1;
+        ++lineno;
+        trim(line);
+        if (line.empty() || line[0] == '#') continue;
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) return fail("expected name = text");
+        Template t;
+        t.name = line.substr(0, eq);
+        std::string body = line.substr(eq + 1);
+        trim(t.name); trim(body);
+        if (t.name.empty()) return fail("empty template name");
+        for (char c : t.name) if (!name_char((unsigned char)c)) return fail("template name must be letters, digits, _ or -");
+        for (const Template& o : set.list) if (o.name == t.name) return fail("duplicate template name");
+        if (body.find(kMark) != std::string::npos) return fail("text contains the reserved word \"zqslot\"");
+        if (lexicon) lexicon_rewrite(*lexicon, body);
+
+        const char* why = nullptr;
+        if (!mark_slots(body, t, marked, why)) return fail(why);
+        size_t uses = 0;
+        for (size_t p = 0; (p = marked.find(kMark, p)) != std::string::npos; p += kMarkLen) ++uses;
+
+        const std::wstring w = u8_to_w(marked);
+        const std::wstring enc = set.vox ? vox_process(w, set.wrap, &set.pack->rules) : w;
+        if (!split_marks(enc, uses, t)) return fail("a slot did not survive VOX encoding (put it next to a space)");
+        set.list.push_back(std::move(t));
+    }
+    return true;
+}
+
+const Template* find_template(const TemplateSet& set, const std::string& name){
+    for (const Template& t : set.list) if (t.name == name) return &t;
+    return nullptr;
+}
+
+} // namespace
+
+bool templates_compile(const std::wstring& path, bool vox, bool wrap, const VoxPackRef& pack,
+                       const Lexicon* lexicon, TemplateSetRef& out, std::wstring& err){
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE){ err = win_error(L"cannot read", path); return false; }
+    std::string text;
+    char buf[16384]; DWORD rd = 0;
+    while (ReadFile(h, buf, sizeof(buf), &rd, nullptr) && rd > 0) text.append(buf, rd);
+    CloseHandle(h);
+    if (text.compare(0, 3, "\xEF\xBB\xBF") == 0) text.erase(0, 3);
+
+    auto set = std::make_shared<TemplateSet>();
+    set->path = path;
+    set->vox  = vox;
+    set->wrap = wrap;
+    set->pack = pack;
+    std::string e;
+    if (vox && !pack){ err = path + L": no rule pack"; return false; }
+    if (!parse_templates(text, *set, lexicon, e)){
+        err = path + L": " + u8_to_w(e);
+        return false;
+    }
+    out = set;
+    return true;
+}
+
+bool template_parse_call(const std::string& args, std::string& name, std::vector<TemplateArg>& kv,
+                         std::string& err){
+    kv.clear();
+    const size_t n = args.size();
+    size_t i = 0;
+    while (i < n && isspace((unsigned char)args[i])) ++i;
+    size_t b = i;
+    while (i < n && !isspace((unsigned char)args[i])) ++i;
+    name = args.substr(b, i - b);
+    if (name.empty()){ err = "missing template name"; return false; }
+
+    // A key starts a whitespace-separated word and is followed directly by '='.
+    auto key_at = [&](size_t p, size_t& eq){
+        size_t e = p;
+        while (e < n && key_char((unsigned char)args[e])) ++e;
+        if (e == p || e >= n || args[e] != '=') return false;
+        eq = e; return true;
+    };
+    while (i < n){
+        while (i < n && isspace((unsigned char)args[i])) ++i;
+        if (i >= n) break;
+        size_t eq;
+        if (!key_at(i, eq)){ err = "expected key=value"; return false; }
+        TemplateArg a;
+        a.key = args.substr(i, eq - i);
+        size_t v = eq + 1;
+        if (v < n && args[v] == '"'){
+            size_t close = args.find('"', v + 1);
+            if (close == std::string::npos){ err = "unterminated quote"; return false; }
+            a.value = args.substr(v + 1, close - v - 1);
+            i = close + 1;
+        } else {
+            // unquoted: up to the next " key="
+            size_t e = v;
+            for (;;){
+                while (e < n && !isspace((unsigned char)args[e])) ++e;
+                size_t w = e;
+                while (w < n && isspace((unsigned char)args[w])) ++w;
+                size_t eq2;
+                if (w >= n || key_at(w, eq2)) break;
+                e = w;
+            }
+            a.value = args.substr(v, e - v);
+            trim(a.value);
+            i = e;
+        }
+        kv.push_back(std::move(a));
+    }
+    return true;
+}
+
+bool template_render(const TemplateSet& set, const std::string& name, const std::vector<TemplateArg>& kv,
+                     std::wstring& out, std::string& err){
+    const Template* t = find_template(set, name);
+    if (!t){ err = "no template named \"" + name + "\""; return false; }
+
+    for (const TemplateArg& a : kv){
+        bool known = false;
+        for (const std::string& s : t->slots) if (s == a.key){ known = true; break; }
+        if (!known){ err = "template \"" + name + "\" has no slot \"" + a.key + "\""; return false; }
+    }
+    // Each slot value is normalized once, however often the template uses it.
+    std::vector<std::wstring> vals(t->slots.size());
+    for (size_t k = 0; k < t->slots.size(); ++k){
+        const TemplateArg* a = nullptr;
+        for (const TemplateArg& x : kv) if (x.key == t->slots[k]) a = &x;   // last one wins
+        if (!a){ err = "missing slot \"" + t->slots[k] + "\""; return false; }
+        if (set.vox) vox_encode_fragment(u8_to_w(a->value), vals[k], &set.pack->rules);
+        else         vals[k] = u8_to_w(a->value);
+    }
+
+    size_t len = 0;
+    for (const std::wstring& s : t->text) len += s.size();
+    for (uint16_t r : t->refs) len += vals[r].size();
+    out.clear();
+    out.reserve(len);
+    out += t->text[0];
+    for (size_t i = 0; i < t->refs.size(); ++i){
+        out += vals[t->refs[i]];
+        out += t->text[i + 1];
+    }
+    return true;
+}
+
+bool templates_match(const TemplateSet& set, bool vox, bool wrap){
+    return set.vox == vox && (!vox || set.wrap == wrap);
+}
+
+std::string templates_describe(const TemplateSet& set){
+    char buf[32];
+    snprintf(buf, sizeof(buf), "count=%u names=", (unsigned)set.list.size());
+    std::string s = buf;
+    for (size_t i = 0; i < set.list.size(); ++i){
+        if (i) s.push_back(',');
+        s += set.list[i].name;
+    }
+    return s + " path=" + w_to_u8(set.path);
+}
+
+bool templates_load(const std::wstring& path, bool vox, bool wrap, const VoxPackRef& pack,
+                    const Lexicon* lexicon, std::wstring& err){
+    TemplateSetRef set;
+    if (!templates_compile(path, vox, wrap, pack, lexicon, set, err)) return false;
+    std::atomic_store(&g_current, set);
+    return true;
+}
+
+TemplateSetRef templates_current(){
+    return std::atomic_load(&g_current);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+#include "vox_rulepack.hpp"
+
+struct Lexicon;
+
+// Announcement templates: one "name = text" per line (UTF-8) with {slot} markers, e.g.
+//   report = Attention: {name}, report to Sector {x}.
+// Each template is encoded once at load (VOX with the given rule pack, or left as plain text)
+// and split at its slots, so "/tmpl report name=Gordon Freeman x=C" only has to normalize
+// the slot values and splice them in.
+struct TemplateSet;
+typedef std::shared_ptr<const TemplateSet> TemplateSetRef;
+
+struct TemplateArg { std::string key, value; };
+
+// `vox` = encode for the VOX path (`wrap` as in vox_process); `lexicon` (may be null) is
+// applied to the template text before encoding.
+bool templates_compile(const std::wstring& path, bool vox, bool wrap, const VoxPackRef& pack,
+                       const Lexicon* lexicon, TemplateSetRef& out, std::wstring& err);
+
+// "NAME key=value key2=value with spaces key3=\"quoted = text\"": a value runs to the next
+// word of the form key=, or is quoted.
+bool template_parse_call(const std::string& args, std::string& name, std::vector<TemplateArg>& kv,
+                         std::string& err);
+// Fills every slot of template `name` (values go through the word-level VOX rules in VOX
+// mode) into `out`. Fails on an unknown template, a missing slot or an unknown key.
+bool template_render(const TemplateSet& set, const std::string& name, const std::vector<TemplateArg>& kv,
+                     std::wstring& out, std::string& err);
+// True when `set` was compiled for this prosody mode (the GUI can switch it at run time).
+bool templates_match(const TemplateSet& set, bool vox, bool wrap);
+// "count=N names=a,b,c path=..."
+std::string templates_describe(const TemplateSet& set);
+
+// The active set, replaced atomically like the rule packs and the lexicon.
+bool templates_load(const std::wstring& path, bool vox, bool wrap, const VoxPackRef& pack,
+                    const Lexicon* lexicon, std::wstring& err);
+TemplateSetRef templates_current();   // null when none is loaded
@@ -20,6 +20,9 @@ void tts_set_rate_percent_ui(int pct){
     if (pct < 0) pct = 0; if (pct > 200) pct = 200;
     g_ui_rate_pct.store(pct, std::memory_order_relaxed);
 }
+int tts_rate_percent_ui(){
+    return g_ui_rate_pct.load(std::memory_order_relaxed);
+}
 void tts_set_pitch_percent_ui(int pct){
     if (pct < 0) pct = 0; if (pct > 200) pct = 200;
     g_ui_pitch_pct.store(pct, std::memory_order_relaxed);
@@ -72,9 +75,13 @@ bool text_looks_tagged(const std::wstring& w){ return w.find(L"\\!") != std::wst
 // -----------------------------------------------------------
 // Notify sink: matches the 1999 speech.h (QWORD tokens)
 struct BufSinkW : public ITTSBufNotifySink, public ITTSNotifySink {
-    LONG    m_ref = 1;
-    Engine* m_eng = nullptr;
-    explicit BufSinkW(Engine* e): m_eng(e) {}
+    LONG     m_ref   = 1;
+    Engine*  m_eng   = nullptr;
+    unsigned m_epoch = 0;
+    BufSinkW(Engine* e, unsigned epoch): m_eng(e), m_epoch(epoch) {}
+
+    // false once tts_audio_reset() has moved on: this sink's text was flushed
+    bool current() const { return m_eng && m_eng->epoch.load(std::memory_order_acquire) == m_epoch; }
 
     // IUnknown
     STDMETHOD(QueryInterface)(REFIID riid, void** ppv) {
@@ -99,17 +106,16 @@ struct BufSinkW : public ITTSBufNotifySink, public ITTSNotifySink {
 
     // ---- ITTSBufNotifySink (QWORD tokens) ----
     STDMETHOD(TextDataStarted)(QWORD /*token*/) {
-        if (m_eng) {
-            m_eng->inflight.fetch_add(1, std::memory_order_relaxed);
-            if (m_eng->notify_hwnd) PostMessageW(m_eng->notify_hwnd, WM_APP_TTS_TEXT_START, 0, 0);
+        if (current()) {
+            if (m_eng->notify_hwnd) PostMessageW(m_eng->notify_hwnd, WM_APP_TTS_TEXT_START, m_epoch, 0);
         }
         return S_OK;
     }
     STDMETHOD(TextDataDone)(QWORD /*token*/, DWORD /*hrFlags*/) {
-        if (m_eng) {
+        if (current()) {
             long v = m_eng->inflight.fetch_sub(1, std::memory_order_relaxed);
             if (v <= 0) m_eng->inflight.store(0, std::memory_order_relaxed);
-            if (m_eng->notify_hwnd) PostMessageW(m_eng->notify_hwnd, WM_APP_TTS_TEXT_DONE, 0, 0);
+            if (m_eng->notify_hwnd) PostMessageW(m_eng->notify_hwnd, WM_APP_TTS_TEXT_DONE, m_epoch, 0);
         }
         return S_OK;
     }
@@ -163,10 +169,11 @@ static bool select_voice_and_audio(Engine& e, int device_index){
     (void)e.cw->QueryInterface(IID_ITTSAttributesW, (void**)&e.attrsW);
 
     // Create/register notify sink (events)
-    e.sink = new BufSinkW(&e);
+    e.sink = new BufSinkW(&e, 0);
     if (e.sink && e.cookie_evt == 0) {
         (void)e.cw->Register((PVOID)(ITTSNotifySink*)e.sink, IID_ITTSNotifySinkW, &e.cookie_evt);
     }
+    e.buf_sink = new BufSinkW(&e, tts_epoch(e));
 
     // Log selected voice
     wchar_t info[512];
@@ -182,7 +189,6 @@ static bool select_voice_and_audio(Engine& e, int device_index){
 // API
 bool tts_init(Engine& e, int device_index){
     tts_shutdown(e);
-    CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
     if (!select_voice_and_audio(e, device_index)) return false;
     dbg(L"[tts] init: PosnGet=%s", e.has_posn ? L"yes" : L"no");
     return true;
@@ -191,6 +197,7 @@ bool tts_init(Engine& e, int device_index){
 void tts_shutdown(Engine& e){
     if (e.cw && e.cookie_evt) { (void)e.cw->UnRegister(e.cookie_evt); e.cookie_evt = 0; }
     if (e.sink)       { e.sink->Release();      e.sink = nullptr; }
+    if (e.buf_sink)   { e.buf_sink->Release();  e.buf_sink = nullptr; }
     if (e.attrsW)     { e.attrsW->Release();    e.attrsW = nullptr; }
     if (e.cw)         { e.cw->Release();        e.cw = nullptr; }
     if (e.audio_dest) { e.audio_dest->Release(); e.audio_dest = nullptr; }
@@ -210,8 +217,26 @@ HRESULT tts_speak(Engine& e, const std::wstring& wtext, bool /*force_tagged*/){
     const VOICECHARSET charset = CHARSET_TEXT;
     const DWORD        flags   = TTSDATAFLAG_TAGGED;
 
-    return e.cw->TextData(charset, flags, s,
-                          (PVOID)(ITTSBufNotifySink*)e.sink, IID_ITTSBufNotifySink);
+    // counted before the call: TextDataDone may arrive before TextData returns
+    e.inflight.fetch_add(1, std::memory_order_relaxed);
+    HRESULT hr = e.cw->TextData(charset, flags, s,
+                                (PVOID)(ITTSBufNotifySink*)e.buf_sink, IID_ITTSBufNotifySink);
+    if (FAILED(hr)) {
+        long v = e.inflight.fetch_sub(1, std::memory_order_relaxed);
+        if (v <= 0) e.inflight.store(0, std::memory_order_relaxed);
+    }
+    return hr;
+}
+
+void tts_audio_reset(Engine& e){
+    if (!e.cw) return;
+    // New epoch first: the TextDataDone calls AudioReset triggers for flushed text are ignored
+    const unsigned epoch = e.epoch.fetch_add(1, std::memory_order_acq_rel) + 1;
+    e.inflight.store(0, std::memory_order_relaxed);
+    BufSinkW* old = e.buf_sink;
+    e.buf_sink = new BufSinkW(&e, epoch);
+    e.cw->AudioReset();
+    if (old) old->Release();   // the engine keeps its own references while it needs them
 }
 
 
@@ -15,17 +15,23 @@ struct Engine {
     ITTSCentralW*    cw         = nullptr;
     ITTSAttributesW* attrsW     = nullptr;
 
-    // Notify sink we use for ITTSBufNotifySink + ITTSNotifySink(W)
+    // Notify sink registered for ITTSNotifySink(W) (AudioStop)
     BufSinkW*        sink       = nullptr;
     DWORD            cookie_evt = 0;      // Register() cookie for ITTSNotifySink(W)
 
+    // ITTSBufNotifySink handed to TextData. tts_audio_reset() starts a new epoch with a new
+    // sink, so callbacks for text the reset flushed no longer touch the counter or the app.
+    BufSinkW*        buf_sink   = nullptr;
+    std::atomic<unsigned> epoch{0};
+
     // Bound audio destination we passed to Select()
     IUnknown*        audio_dest = nullptr;
 
     // Where the sink posts notifications
     HWND             notify_hwnd = nullptr;
 
-    // Inflight counter: TextDataStarted++ / TextDataDone--
+    // Utterances handed to TextData whose TextDataDone has not come back yet (this epoch):
+    // tts_speak()++ / TextDataDone--, so the count is right before the engine even starts
     std::atomic<long> inflight{0};
 
     // PosnGet availability
@@ -36,11 +42,12 @@ struct Engine {
 #ifndef WM_APP
 #  define WM_APP 0x8000
 #endif
-#define WM_APP_TTS_TEXT_START    (WM_APP + 8)
-#define WM_APP_TTS_TEXT_DONE     (WM_APP + 7)
+#define WM_APP_TTS_TEXT_START    (WM_APP + 8)   // wParam: epoch of the utterance
+#define WM_APP_TTS_TEXT_DONE     (WM_APP + 7)   // wParam: epoch of the utterance
 #define WM_APP_TTS_AUDIO_DONE    (WM_APP + 21)
 
-// Init / shutdown
+// Init / shutdown. The calling thread must already be in a single-threaded COM apartment
+// (the speech thread joins one for its whole life).
 bool tts_init   (Engine& e, int device_index /* -1 = default mapper */);
 void tts_shutdown(Engine& e);
 
@@ -51,7 +58,8 @@ inline void tts_set_notify_hwnd(Engine& e, HWND h){ e.notify_hwnd = h; }
 HRESULT tts_speak(Engine& e, const std::wstring& wtext, bool force_tagged = false);
 
 // Engine-level controls
-inline void tts_audio_reset (Engine& e){ if (e.cw) e.cw->AudioReset(); }
+void        tts_audio_reset (Engine& e);   // flush everything queued; starts a new epoch, inflight = 0
+inline unsigned tts_epoch(const Engine& e){ return e.epoch.load(std::memory_order_acquire); }
 inline void tts_audio_pause (Engine& e){ if (e.cw) e.cw->AudioPause(); }
 inline void tts_audio_resume(Engine& e){ if (e.cw) e.cw->AudioResume(); }
 
@@ -61,6 +69,7 @@ void tts_set_volume_percent(Engine& e, int pct);
 // UI → stash for next utterance (no immediate engine I/O)
 void tts_set_rate_percent_ui(int pct);
 void tts_set_pitch_percent_ui(int pct);
+int  tts_rate_percent_ui();   // the stashed rate (0..200, 100 = 1.00)
 
 // Build vendor tag prefix for next utterance ("" if defaults)
 std::wstring tts_vendor_prefix_from_ui();
@@ -77,9 +86,7 @@ inline void tts_set_rate_percent(Engine& e, int pct){
     if (pct < 30) pct = 30; if (pct > 200) pct = 200;
     double r = pct / 100.0;
     wchar_t buf[32]; _snwprintf(buf, 31, L" \\!R%.2f ", r); // sticky rate
-    SDATA s{ (PVOID)buf, (DWORD)((wcslen(buf)+1)*sizeof(wchar_t)) };
-    (void)e.cw->TextData(CHARSET_TEXT, TTSDATAFLAG_TAGGED, s,
-                         (PVOID)(ITTSBufNotifySink*)e.sink, IID_ITTSBufNotifySink);
+    (void)tts_speak(e, buf);
 }
 
 inline void tts_set_pitch_percent(Engine& e, int pct){
@@ -87,9 +94,7 @@ inline void tts_set_pitch_percent(Engine& e, int pct){
     if (pct < 50) pct = 50; if (pct > 150) pct = 150;
     double p = pct / 100.0;
     wchar_t buf[32]; _snwprintf(buf, 31, L" \\!%%%.2f ", p); // sticky pitch (%%)
-    SDATA s{ (PVOID)buf, (DWORD)((wcslen(buf)+1)*sizeof(wchar_t)) };
-    (void)e.cw->TextData(CHARSET_TEXT, TTSDATAFLAG_TAGGED, s,
-                         (PVOID)(ITTSBufNotifySink*)e.sink, IID_ITTSBufNotifySink);
+    (void)tts_speak(e, buf);
 }
 
 // Helper used by main.cpp
@@ -1,22 +1,116 @@
 #include "util.hpp"
 #include <cwctype>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && __SIZEOF_WCHAR_T__ == 2
+#include <emmintrin.h>
+#define NETTTS_HAVE_SSE2_PATH 1
+#endif
 
 void rtrim(std::string &s){ while(!s.empty()&&(s.back()=='\r'||s.back()=='\n')) s.pop_back(); }
 
-std::wstring u8_to_w(const std::string& s){
-    if(s.empty()) return L"";
-    int n=MultiByteToWideChar(CP_UTF8,0,s.c_str(),(int)s.size(),nullptr,0);
-    std::wstring w(n,L'\0');
-    MultiByteToWideChar(CP_UTF8,0,s.c_str(),(int)s.size(),&w[0],n);
+// ---- ASCII fast paths ----
+// Chat and announcement text is nearly all ASCII, so both conversions first copy the leading
+// ASCII run themselves (16 units per step with SSE2, 8 with plain 64-bit words otherwise)
+// and only hand the rest, starting on a character boundary, to the Win32 converters.
+// The output is sized for the worst case up front, so each call is a single pass with one
+// allocation instead of the usual size-query + convert pair.
+namespace {
+
+size_t widen_ascii_swar(const char* p, size_t n, wchar_t* out){
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8){
+        uint64_t v; memcpy(&v, p + i, 8);
+        if (v & 0x8080808080808080ull) break;
+        for (int k = 0; k < 8; ++k) out[i+k] = (wchar_t)(unsigned char)p[i+k];
+    }
+    for (; i < n && !(p[i] & 0x80); ++i) out[i] = (wchar_t)p[i];
+    return i;
+}
+
+size_t narrow_ascii_swar(const wchar_t* p, size_t n, char* out){
+    size_t i = 0;
+    for (; i < n && (unsigned)p[i] < 0x80; ++i) out[i] = (char)p[i];
+    return i;
+}
+
+#ifdef NETTTS_HAVE_SSE2_PATH
+__attribute__((target("sse2")))
+size_t widen_ascii_sse2(const char* p, size_t n, wchar_t* out){
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16){
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        if (_mm_movemask_epi8(v)) break;   // some byte has the high bit set
+        _mm_storeu_si128((__m128i*)(out + i),     _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+    return i + widen_ascii_swar(p + i, n - i, out + i);
+}
+
+__attribute__((target("sse2")))
+size_t narrow_ascii_sse2(const wchar_t* p, size_t n, char* out){
+    const __m128i hi = _mm_set1_epi16((short)0xFF80);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16){
+        __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(p + i + 8));
+        __m128i any = _mm_and_si128(_mm_or_si128(a, b), hi);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, _mm_setzero_si128())) != 0xFFFF) break;
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(a, b));
+    }
+    return i + narrow_ascii_swar(p + i, n - i, out + i);
+}
+
+bool cpu_has_sse2(){
+    static const bool yes = []{ __builtin_cpu_init(); return __builtin_cpu_supports("sse2") != 0; }();
+    return yes;
+}
+#endif
+
+size_t widen_ascii(const char* p, size_t n, wchar_t* out){
+#ifdef NETTTS_HAVE_SSE2_PATH
+    if (cpu_has_sse2()) return widen_ascii_sse2(p, n, out);
+#endif
+    return widen_ascii_swar(p, n, out);
+}
+
+size_t narrow_ascii(const wchar_t* p, size_t n, char* out){
+#ifdef NETTTS_HAVE_SSE2_PATH
+    if (cpu_has_sse2()) return narrow_ascii_sse2(p, n, out);
+#endif
+    return narrow_ascii_swar(p, n, out);
+}
+
+} // namespace
+
+std::wstring u8_to_w(const char* s, size_t n){
+    std::wstring w;
+    if(!n) return w;
+    w.resize(n);                                   // UTF-16 never needs more units than UTF-8 bytes
+    size_t i = widen_ascii(s, n, &w[0]);
+    if(i < n){
+        int k = MultiByteToWideChar(CP_UTF8,0,s+i,(int)(n-i),&w[i],(int)(n-i));
+        w.resize(i + (size_t)std::max(k, 0));
+    }
     return w;
 }
-std::string  w_to_u8(const std::wstring& w){
-    if(w.empty()) return "";
-    int n=WideCharToMultiByte(CP_UTF8,0,w.c_str(),(int)w.size(),nullptr,0,nullptr,nullptr);
-    std::string s(n,'\0');
-    WideCharToMultiByte(CP_UTF8,0,w.c_str(),(int)w.size(),&s[0],n,nullptr,nullptr);
+std::wstring u8_to_w(const std::string& s){ return u8_to_w(s.data(), s.size()); }
+
+std::string w_to_u8(const wchar_t* w, size_t n){
+    std::string s;
+    if(!n) return s;
+    s.resize(n * 3);                               // a UTF-16 unit never needs more than 3 bytes
+    size_t i = narrow_ascii(w, n, &s[0]);
+    if(i < n){
+        int k = WideCharToMultiByte(CP_UTF8,0,w+i,(int)(n-i),&s[i],(int)(s.size()-i),nullptr,nullptr);
+        i += (size_t)std::max(k, 0);
+    }
+    s.resize(i);
     return s;
 }
+std::string w_to_u8(const std::wstring& w){ return w_to_u8(w.data(), w.size()); }
 
 bool is_digits(const std::wstring& s){
     if(s.empty()) return false;
@@ -3,7 +3,10 @@
 #include <windows.h>
 
 void rtrim(std::string& s);
+// UTF-8 <-> UTF-16, single pass with an ASCII fast path (SSE2 when the CPU has it)
 std::wstring u8_to_w(const std::string& s);
+std::wstring u8_to_w(const char* s, size_t n);
 std::string  w_to_u8(const std::wstring& w);
+std::string  w_to_u8(const wchar_t* w, size_t n);
 bool is_digits(const std::wstring& s);
 bool is_digits_token(const std::string& s);
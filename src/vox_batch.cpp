@@ -0,0 +1,197 @@
+#include "vox_batch.hpp"
+#include "vox_parser.hpp"
+#include "lexicon.hpp"
+#include "sanitize.hpp"
+#include "util.hpp"
+#include <windows.h>
+#include <vector>
+#include <algorithm>
+
+// The input is handled in blocks of lines so memory stays bounded on huge files. Within a
+// block every sentence is one work item; workers claim items in small runs, and whoever
+// encodes the last sentence of a line joins and finishes that line (UTF-8, ready to write).
+namespace {
+
+constexpr size_t kBlockBytes = 4u << 20;   // input bytes per block
+constexpr LONG   kClaim      = 16;         // items claimed per interlocked op
+
+struct BatchLine {
+    std::wstring  text;
+    const char*   eol      = "";
+    size_t        first    = 0;     // items [first, first+count)
+    size_t        count    = 0;
+    volatile LONG remaining = 0;
+    std::string   out;
+};
+
+struct BatchItem {
+    size_t       line;
+    VoxSpan      span;
+    std::wstring vox;
+};
+
+struct BatchBlock {
+    std::vector<BatchLine> lines;
+    std::vector<BatchItem> items;
+    volatile LONG          next = 0;
+    bool                   wrap = true;
+    const VoxRules*        rules = nullptr;
+};
+
+void finish_line(BatchBlock& b, BatchLine& ln){
+    std::wstring joined;
+    size_t n = 0;
+    for (size_t k = ln.first; k < ln.first + ln.count; ++k) n += b.items[k].vox.size() + 1;
+    joined.reserve(n);
+    for (size_t k = ln.first; k < ln.first + ln.count; ++k){
+        std::wstring& v = b.items[k].vox;
+        if (v.empty()) continue;
+        if (!joined.empty()) joined.push_back(L' ');
+        joined += v;
+        std::wstring().swap(v);
+    }
+    ln.out = w_to_u8(vox_finish_text(joined, b.wrap));
+}
+
+DWORD WINAPI batch_worker(LPVOID p){
+    BatchBlock& b = *(BatchBlock*)p;
+    const LONG total = (LONG)b.items.size();
+    for (;;){
+        LONG i = InterlockedExchangeAdd(&b.next, kClaim);
+        if (i >= total) break;
+        LONG end = std::min(total, i + kClaim);
+        for (; i < end; ++i){
+            BatchItem& it = b.items[i];
+            BatchLine& ln = b.lines[it.line];
+            vox_encode_sentence(ln.text, it.span, it.vox, b.rules);
+            if (InterlockedDecrement(&ln.remaining) == 0) finish_line(b, ln);
+        }
+    }
+    return 0;
+}
+
+void run_block(BatchBlock& b, int threads){
+    b.next = 0;
+    int n = (int)std::min<size_t>((size_t)threads, (b.items.size() + kClaim - 1) / kClaim);
+    if (n <= 1){ batch_worker(&b); return; }
+
+    std::vector<HANDLE> hs;
+    for (int t = 1; t < n; ++t){
+        HANDLE h = CreateThread(nullptr, 0, batch_worker, &b, 0, nullptr);
+        if (h) hs.push_back(h);
+    }
+    batch_worker(&b);   // the calling thread works too
+    for (size_t k = 0; k < hs.size(); k += MAXIMUM_WAIT_OBJECTS){
+        DWORD cnt = (DWORD)std::min<size_t>(hs.size() - k, MAXIMUM_WAIT_OBJECTS);
+        WaitForMultipleObjects(cnt, &hs[k], TRUE, INFINITE);
+    }
+    for (HANDLE h : hs) CloseHandle(h);
+}
+
+std::wstring last_error_text(const wchar_t* what, const std::wstring& path){
+    wchar_t buf[64]; _snwprintf(buf, 63, L" (error %lu)", GetLastError()); buf[63] = 0;
+    return std::wstring(what) + L" " + path + buf;
+}
+
+bool read_file(const std::wstring& path, std::string& data){
+    HANDLE h = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER sz{};
+    bool ok = GetFileSizeEx(h, &sz) != 0;
+    if (ok){
+        data.resize((size_t)sz.QuadPart);
+        size_t got = 0;
+        while (ok && got < data.size()){
+            DWORD want = (DWORD)std::min<size_t>(data.size() - got, 1u << 30), rd = 0;
+            ok = ReadFile(h, &data[got], want, &rd, nullptr) && rd > 0;
+            got += rd;
+        }
+    }
+    CloseHandle(h);
+    return ok;
+}
+
+bool write_all(HANDLE h, const char* p, size_t n){
+    while (n){
+        DWORD wr = 0;
+        if (!WriteFile(h, p, (DWORD)std::min<size_t>(n, 1u << 30), &wr, nullptr) || !wr) return false;
+        p += wr; n -= wr;
+    }
+    return true;
+}
+
+} // namespace
+
+bool vox_batch_file(const std::wstring& in_path, const std::wstring& out_path,
+                    bool wrap_vox_tags, const VoxRules* rules, const Lexicon* lexicon,
+                    bool sanitize, int threads, VoxBatchStats& st, std::wstring& err){
+    st = VoxBatchStats{};
+    std::string data;
+    if (!read_file(in_path, data)){ err = last_error_text(L"cannot read", in_path); return false; }
+
+    HANDLE out = CreateFileW(out_path.c_str(), GENERIC_WRITE, 0, nullptr,
+                             CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (out == INVALID_HANDLE_VALUE){ err = last_error_text(L"cannot write", out_path); return false; }
+
+    if (threads <= 0){
+        SYSTEM_INFO si; GetSystemInfo(&si);
+        threads = (int)std::max<DWORD>(1, si.dwNumberOfProcessors);
+    }
+    st.threads  = threads;
+    st.in_bytes = data.size();
+
+    size_t pos = (data.compare(0, 3, "\xEF\xBB\xBF") == 0) ? 3 : 0;   // skip a UTF-8 BOM
+    BatchBlock b;
+    b.wrap  = wrap_vox_tags;
+    b.rules = rules;
+    std::vector<VoxSpan> spans;
+    std::string block_out, line_u8;
+    bool ok = true;
+
+    while (ok && pos < data.size()){
+        // gather one block of lines and their sentences
+        b.lines.clear(); b.items.clear();
+        size_t block_end = std::min(data.size(), pos + kBlockBytes);
+        while (pos < data.size() && (pos < block_end || b.lines.empty())){
+            size_t nl = data.find('\n', pos);
+            size_t end = (nl == std::string::npos) ? data.size() : nl;
+            size_t next = (nl == std::string::npos) ? data.size() : nl + 1;
+            bool cr = end > pos && data[end-1] == '\r';
+            if (cr) --end;
+
+            b.lines.emplace_back();
+            BatchLine& ln = b.lines.back();
+            if (sanitize || lexicon){
+                line_u8.assign(data, pos, end - pos);
+                if (sanitize) chat_sanitize(line_u8);
+                if (lexicon) lexicon_rewrite(*lexicon, line_u8);
+                ln.text = u8_to_w(line_u8);
+            } else {
+                ln.text = u8_to_w(data.data() + pos, end - pos);
+            }
+            ln.eol  = (nl == std::string::npos) ? "" : (cr ? "\r\n" : "\n");
+            vox_split_sentences(ln.text, spans);
+            ln.first = b.items.size();
+            for (const VoxSpan& s : spans){
+                if (s.b == s.a) continue;
+                b.items.push_back(BatchItem{b.lines.size() - 1, s, std::wstring()});
+            }
+            ln.count = b.items.size() - ln.first;
+            ln.remaining = (LONG)ln.count;
+            pos = next;
+        }
+        st.lines     += b.lines.size();
+        st.sentences += b.items.size();
+
+        run_block(b, threads);
+
+        block_out.clear();
+        for (const BatchLine& ln : b.lines){ block_out += ln.out; block_out += ln.eol; }
+        st.out_bytes += block_out.size();
+        ok = write_all(out, block_out.data(), block_out.size());
+    }
+    CloseHandle(out);
+    if (!ok) err = last_error_text(L"write failed on", out_path);
+    return ok;
+}
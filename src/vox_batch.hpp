@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+
+struct VoxRules;
+struct Lexicon;
+
+// Offline VOX transform for pre-generating scripts (--vox-batch IN OUT).
+// Reads the UTF-8 file `in_path` and writes one line per input line to `out_path`, each the
+// vox_process() output for that line (blank lines stay blank, line endings are kept).
+// `sanitize` runs chat_sanitize() and a non-null `lexicon` rewrites each line first, in the
+// server's order. Unlike the server, which queues each sentence as its own chunk, a line
+// keeps one \!wH1...\!wH0 wrap.
+// Sentences are encoded with `rules` (nullptr = built-in) on a pool of `threads` workers
+// (0 = one per CPU); output order is the input order. Returns false and fills `err` if a file cannot be read or written.
+struct VoxBatchStats {
+    size_t lines     = 0;
+    size_t sentences = 0;
+    size_t in_bytes  = 0;
+    size_t out_bytes = 0;
+    int    threads   = 0;
+};
+
+bool vox_batch_file(const std::wstring& in_path, const std::wstring& out_path,
+                    bool wrap_vox_tags, const VoxRules* rules, const Lexicon* lexicon,
+                    bool sanitize, int threads, VoxBatchStats& st, std::wstring& err);
@@ -0,0 +1,112 @@
+#include "vox_cache.hpp"
+#include <list>
+#include <unordered_map>
+#include <string_view>
+#include <cstdint>
+
+namespace {
+
+struct Entry {
+    std::wstring              text;
+    bool                      wrap = false;
+    uint32_t                  pack = 0;
+    std::vector<std::wstring> chunks;
+    size_t                    bytes = 0;
+};
+
+// Lookups key on a view of the caller's string, so a probe never allocates.
+struct Key {
+    std::wstring_view text;
+    bool              wrap;
+    uint32_t          pack;
+    bool operator==(const Key& o) const { return wrap==o.wrap && pack==o.pack && text==o.text; }
+};
+struct KeyHash {
+    size_t operator()(const Key& k) const {
+        return std::hash<std::wstring_view>()(k.text) ^ (k.wrap ? 0x9e3779b9u : 0u) ^ ((size_t)k.pack << 1);
+    }
+};
+
+constexpr size_t kEntryOverhead = 96;   // list node + map node + vector header, roughly
+
+std::list<Entry>                                                g_lru;   // front = most recent
+std::unordered_map<Key, std::list<Entry>::iterator, KeyHash>    g_index;
+VoxCacheStats                                                   g_stats;
+size_t g_max_entries = 256;
+size_t g_max_bytes   = 1u << 20;
+
+size_t entry_bytes(const Entry& e){
+    size_t n = e.text.size();
+    for (const auto& c : e.chunks) n += c.size();
+    return n * sizeof(wchar_t) + kEntryOverhead;
+}
+
+void evict_to_fit(){
+    while (!g_lru.empty() && (g_lru.size() > g_max_entries || g_stats.bytes > g_max_bytes)){
+        const Entry& e = g_lru.back();
+        g_index.erase(Key{ e.text, e.wrap, e.pack });
+        g_stats.bytes -= e.bytes;
+        g_lru.pop_back();
+        ++g_stats.evictions;
+    }
+}
+
+} // namespace
+
+void vox_cache_set_limits(size_t max_entries, size_t max_bytes){
+    g_max_entries = max_entries;
+    g_max_bytes   = max_bytes;
+    evict_to_fit();
+}
+
+bool vox_cache_lookup(const std::wstring& in, bool wrap_vox_tags, uint32_t pack_id,
+                      std::vector<std::wstring>& chunks){
+    if (g_max_entries == 0) return false;
+    auto it = g_index.find(Key{ in, wrap_vox_tags, pack_id });
+    if (it == g_index.end()){ ++g_stats.misses; return false; }
+    g_lru.splice(g_lru.begin(), g_lru, it->second);
+    chunks = it->second->chunks;
+    ++g_stats.hits;
+    return true;
+}
+
+void vox_cache_store(const std::wstring& in, bool wrap_vox_tags, uint32_t pack_id,
+                     const std::vector<std::wstring>& chunks){
+    if (g_max_entries == 0) return;
+    auto it = g_index.find(Key{ in, wrap_vox_tags, pack_id });
+    if (it != g_index.end()){
+        // refresh in place (the key view stays valid: the node and its text don't move)
+        Entry& e = *it->second;
+        g_stats.bytes -= e.bytes;
+        e.chunks = chunks;
+        e.bytes  = entry_bytes(e);
+        g_stats.bytes += e.bytes;
+        g_lru.splice(g_lru.begin(), g_lru, it->second);
+    } else {
+        Entry e;
+        e.text   = in;
+        e.wrap   = wrap_vox_tags;
+        e.pack   = pack_id;
+        e.chunks = chunks;
+        e.bytes  = entry_bytes(e);
+        if (e.bytes > g_max_bytes) return;   // would evict everything else; not worth keeping
+        g_lru.push_front(std::move(e));
+        g_index.emplace(Key{ g_lru.front().text, g_lru.front().wrap, g_lru.front().pack }, g_lru.begin());
+        g_stats.bytes += g_lru.front().bytes;
+    }
+    evict_to_fit();
+}
+
+void vox_cache_clear(){
+    g_index.clear();
+    g_lru.clear();
+    g_stats.bytes = 0;
+}
+
+VoxCacheStats vox_cache_stats(){
+    VoxCacheStats s = g_stats;
+    s.entries     = g_lru.size();
+    s.max_entries = g_max_entries;
+    s.max_bytes   = g_max_bytes;
+    return s;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Bounded LRU cache in front of the VOX encoder, for overlays and bots that repeat the same
+// lines. Keyed by the input text, the wrap mode and the rule pack id; the value is the list of
+// chunks the encoder produced for that line. Owned by the UI thread (not thread-safe).
+struct VoxCacheStats {
+    unsigned long long hits      = 0;
+    unsigned long long misses    = 0;
+    unsigned long long evictions = 0;
+    size_t             entries   = 0;
+    size_t             bytes     = 0;   // approximate: text + per-entry overhead
+    size_t             max_entries = 0;
+    size_t             max_bytes   = 0;
+};
+
+// max_entries==0 disables the cache (and drops anything already in it).
+void vox_cache_set_limits(size_t max_entries, size_t max_bytes);
+// On a hit copies the cached chunks into `chunks` and marks the entry most recently used.
+bool vox_cache_lookup(const std::wstring& in, bool wrap_vox_tags, uint32_t pack_id,
+                      std::vector<std::wstring>& chunks);
+void vox_cache_store(const std::wstring& in, bool wrap_vox_tags, uint32_t pack_id,
+                     const std::vector<std::wstring>& chunks);
+void vox_cache_clear();
+VoxCacheStats vox_cache_stats();
@@ -1,330 +1,1243 @@
 #include "vox_parser.hpp"
+#include "vox_stages.hpp"
+#include "vox_rules.hpp"
 #include <vector>
-#include <regex>
 #include <cwctype>
-#include <sstream>
+#include <cwchar>
+#include <cstdint>
 #include <algorithm>
+#if NETTTS_VOX_STATS
+#include <atomic>
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#define VOX_STATS_TSC 1
+#else
+#include <chrono>
+#endif
+#endif
+
+// ---- Stage hook (see vox_stages.hpp) ----
+static VoxStageHook g_stage_hook = nullptr;
+static void*        g_stage_user = nullptr;
+
+void vox_set_stage_hook(VoxStageHook hook, void* user){ g_stage_hook = hook; g_stage_user = user; }
+
+const char* vox_stage_name(int stage){
+    static const char* const names[VOX_STAGE_COUNT] = {
+        "split_sentences", "tokenize", "apply_thee_rule", "apply_leadin_break",
+        "apply_time_numbers", "build_beats", "normalize_letter_tokens", "tidy", "finish_chunk"
+    };
+    return (stage>=0 && stage<VOX_STAGE_COUNT) ? names[stage] : "?";
+}
 
-static inline std::wstring trim(const std::wstring& s){
-    size_t a=0,b=s.size();
-    while(a<b && iswspace(s[a])) ++a;
-    while(b>a && iswspace(s[b-1])) --b;
-    return s.substr(a,b-a);
+// ---- Stage counters (NETTTS_VOX_STATS, see vox_stages.hpp) ----
+// Blocks are never freed: a thread claims an idle one (or adds one to the list) on its first
+// stage and hands it back at exit, so counts of finished threads stay in the totals. Only the
+// owner writes a block, so updates are plain relaxed load+store. A reset bumps g_stats_epoch;
+// blocks from an older epoch read as zero and their owner clears them on its next stage.
+#if NETTTS_VOX_STATS
+struct StageCell {
+    std::atomic<uint64_t> calls, ticks, ticks_max, units_in, units_out, growth_max;
+    std::atomic<uint64_t> hist[VOX_STAGE_HIST];
+};
+struct StageBlock {
+    StageCell              cell[VOX_STAGE_COUNT];
+    uint64_t               t0[VOX_STAGE_COUNT];
+    uint64_t               in0[VOX_STAGE_COUNT];
+    std::atomic<uint32_t>  epoch;
+    std::atomic<bool>      busy;
+    StageBlock*            next;
+};
+static std::atomic<StageBlock*> g_stat_blocks{nullptr};
+static std::atomic<uint32_t>    g_stats_epoch{0};
+
+static StageBlock* claim_stage_block(){
+    for(StageBlock* b = g_stat_blocks.load(std::memory_order_acquire); b; b = b->next){
+        bool idle = false;
+        if(b->busy.compare_exchange_strong(idle, true)) return b;
+    }
+    StageBlock* b = new StageBlock();   // value-initialized: all counters zero
+    b->busy.store(true);
+    b->epoch.store(g_stats_epoch.load());
+    b->next = g_stat_blocks.load();
+    while(!g_stat_blocks.compare_exchange_weak(b->next, b)) {}
+    return b;
 }
-static inline std::wstring to_lower(std::wstring s){
-    for(auto& c: s) c=(wchar_t)towlower(c);
-    return s;
+struct StageOwner {
+    StageBlock* b = claim_stage_block();
+    ~StageOwner(){ b->busy.store(false, std::memory_order_release); }
+};
+static inline StageBlock& stage_block(){
+    static thread_local StageOwner owner;
+    return *owner.b;
 }
-static inline bool is_all_digits(const std::wstring& t){
-    if(t.empty()) return false;
-    for(wchar_t c: t) if(!iswdigit(c)) return false;
-    return true;
+
+static inline uint64_t stage_clock(){
+#ifdef VOX_STATS_TSC
+    return __rdtsc();
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
 }
-static inline bool is_titlecase_word(const std::wstring& t){
-    if(t.empty()) return false;
-    if(!iswalpha(t[0]) || !iswupper(t[0])) return false;
-    return true;
+static inline void bump(std::atomic<uint64_t>& a, uint64_t v){
+    a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+static inline void raise(std::atomic<uint64_t>& a, uint64_t v){
+    if(v > a.load(std::memory_order_relaxed)) a.store(v, std::memory_order_relaxed);
+}
+static inline int tick_bucket(uint64_t t){
+    int k = 0;
+    while(t > 1 && k < VOX_STAGE_HIST-1){ t >>= 1; ++k; }
+    return k;
 }
-static inline std::wstring strip_trailing_punct(std::wstring t){
-    while(!t.empty()){
-        wchar_t c = t.back();
-        if(c==L','||c==L'.'||c==L';'||c==L':'||c==L'!'||c==L'?'||c==L'"'||c==L'\'') t.pop_back();
-        else break;
+static void clear_block(StageBlock& b){
+    for(StageCell& c : b.cell){
+        c.calls.store(0); c.ticks.store(0); c.ticks_max.store(0);
+        c.units_in.store(0); c.units_out.store(0); c.growth_max.store(0);
+        for(auto& h : c.hist) h.store(0);
     }
-    return t;
 }
-static inline bool ends_with_br(const std::wstring& s){
-    size_t n = s.size();
-    return n >= 5 && s.compare(n-5, 5, L" \\!br") == 0;
+
+static inline void stats_begin(VoxStage st, size_t units){
+    StageBlock& b = stage_block();
+    b.in0[st] = units;
+    b.t0[st]  = stage_clock();
+}
+static inline void stats_end(VoxStage st, size_t units){
+    uint64_t t1 = stage_clock();
+    StageBlock& b = stage_block();
+    uint32_t ep = g_stats_epoch.load(std::memory_order_relaxed);
+    if(b.epoch.load(std::memory_order_relaxed) != ep){ clear_block(b); b.epoch.store(ep, std::memory_order_release); }
+    StageCell& c = b.cell[st];
+    uint64_t dt = t1 - b.t0[st];
+    bump(c.calls, 1);
+    bump(c.ticks, dt);
+    raise(c.ticks_max, dt);
+    bump(c.hist[tick_bucket(dt)], 1);
+    bump(c.units_in, b.in0[st]);
+    bump(c.units_out, units);
+    if(b.in0[st]) raise(c.growth_max, (uint64_t)units * 1000 / b.in0[st]);
 }
 
-// Sentence splitter (keeps terminator punctuation attached)
-static std::vector<std::wstring> split_sentences(const std::wstring& in){
-    std::vector<std::wstring> out;
-    std::wstring cur;
+bool vox_stage_stats(VoxStageStats out[VOX_STAGE_COUNT]){
+    for(int st=0; st<VOX_STAGE_COUNT; ++st) out[st] = VoxStageStats{};
+    uint32_t ep = g_stats_epoch.load();
+    for(StageBlock* b = g_stat_blocks.load(std::memory_order_acquire); b; b = b->next){
+        if(b->epoch.load(std::memory_order_acquire) != ep) continue;
+        for(int st=0; st<VOX_STAGE_COUNT; ++st){
+            const StageCell& c = b->cell[st];
+            VoxStageStats& o = out[st];
+            o.calls     += c.calls.load(std::memory_order_relaxed);
+            o.ticks     += c.ticks.load(std::memory_order_relaxed);
+            o.units_in  += c.units_in.load(std::memory_order_relaxed);
+            o.units_out += c.units_out.load(std::memory_order_relaxed);
+            o.ticks_max  = std::max<uint64_t>(o.ticks_max, c.ticks_max.load(std::memory_order_relaxed));
+            o.growth_max = std::max<uint64_t>(o.growth_max, c.growth_max.load(std::memory_order_relaxed));
+            for(int k=0; k<VOX_STAGE_HIST; ++k) o.hist[k] += c.hist[k].load(std::memory_order_relaxed);
+        }
+    }
+    return true;
+}
+void vox_stage_stats_reset(){ g_stats_epoch.fetch_add(1); }
+#ifdef VOX_STATS_TSC
+const char* vox_stage_tick_unit(){ return "cycles"; }
+#else
+const char* vox_stage_tick_unit(){ return "ns"; }
+#endif
+#else
+static inline void stats_begin(VoxStage, size_t){}
+static inline void stats_end(VoxStage, size_t){}
+bool vox_stage_stats(VoxStageStats out[VOX_STAGE_COUNT]){
+    for(int st=0; st<VOX_STAGE_COUNT; ++st) out[st] = VoxStageStats{};
+    return false;
+}
+void vox_stage_stats_reset(){}
+const char* vox_stage_tick_unit(){ return "ns"; }
+#endif
+
+// `units` is the stage's input size at begin and its output size at end (see VoxStageStats).
+static inline void stage_begin(VoxStage st, size_t units){
+    if(g_stage_hook) g_stage_hook(g_stage_user, st, false);
+    stats_begin(st, units);
+}
+static inline void stage_end(VoxStage st, size_t units){
+    stats_end(st, units);
+    if(g_stage_hook) g_stage_hook(g_stage_user, st, true);
+}
+
+
+// Trimmed [a,b) span of a string
+typedef VoxSpan Span;
+static inline Span trim_span(const std::wstring& s, size_t a, size_t b){
+    while(a<b && iswspace(s[a])) ++a;
+    while(b>a && iswspace(s[b-1])) --b;
+    return Span{a,b};
+}
+
+// A '.' between two digits (98.6, 1.5) is part of a number, not a sentence end
+static inline bool is_decimal_point(const std::wstring& s, size_t i){
+    return i>0 && i+1<s.size() && iswdigit(s[i-1]) && iswdigit(s[i+1]);
+}
+
+// Sentence splitter (keeps terminator punctuation attached); reports trimmed spans of `in`
+static void split_sentences(const std::wstring& in, std::vector<Span>& out){
+    out.clear();
+    size_t start = 0;
     for(size_t i=0;i<in.size();++i){
         wchar_t c = in[i];
-        cur.push_back(c);
-        if(c==L'.' || c==L'!' || c==L'?'){
+        if((c==L'.' && !is_decimal_point(in, i)) || c==L'!' || c==L'?'){
             size_t j=i+1;
-            while(j<in.size() && (in[j]==L'"' || in[j]==L'\'')) { cur.push_back(in[j]); ++j; }
-            out.push_back(trim(cur));
-            cur.clear();
+            while(j<in.size() && (in[j]==L'"' || in[j]==L'\'')) ++j;
+            out.push_back(trim_span(in, start, j));
+            start = j;
             i = j-1;
         }
     }
-    std::wstring tail = trim(cur);
-    if(!tail.empty()) out.push_back(tail);
-    return out;
+    Span tail = trim_span(in, start, in.size());
+    if(tail.b>tail.a) out.push_back(tail);
 }
 
-// Lead-in break after short opening phrases
-static void apply_leadin_break(std::wstring& s){
-    static const std::wregex r(LR"(^\s*((?:Now|Please|A\s+reminder|On\s+behalf\s+of|Good\s+(?:morning|evening)|This\s+(?:automated\s+train|tram)))\b)",
-                               std::regex_constants::icase);
-    std::wsmatch m;
-    if(std::regex_search(s, m, r)){
-        std::wstring head = trim(m.str(0));
-        std::wstring rest = trim(s.substr(m.length()));
-        s = head + L" \\!br " + rest;
-    }
+
+// ---- Sentence token array ----
+// Each sentence is split on whitespace exactly once. Every rule below reads and edits this
+// array (rewritten tokens append their new text to Sentence::buf and move their span); the
+// text is only joined back into a string when tidy() serializes the finished sentence.
+enum Wt { LIGHT, MEDIUM, HEAVY };
+enum TokKind : uint8_t { TK_WORD, TK_TAG };   // TK_TAG: exactly \!br, \!wH1 or \!wH0
+
+struct Tok {
+    uint32_t off  = 0;       // span in Sentence::buf
+    uint32_t len  = 0;
+    uint32_t core = 0;       // length without trailing , . ; : ! ? " '
+    uint32_t hash = 0;       // FNV-1a of the lowercased core
+    uint16_t cls  = 0;       // WordClass bits of the lowercased core
+    uint8_t  kind = TK_WORD;
+    int8_t   wt   = -1;      // cached weight(), -1 until first asked
+    int8_t   syl  = -1;      // cached syllables() of the core
+};
+
+struct Sentence {
+    const VoxRules*  R = nullptr;
+    std::wstring     buf;
+    std::vector<Tok> toks;
+    std::vector<Tok> spare;   // output array for rewriting passes, swapped with toks when done
+};
+
+// ---- Built-in rules ----
+// Every word list the rules consult is merged at compile time into one perfect-hash table
+// (hash-and-displace: the token hash picks a bucket, the bucket's displacement picks a slot
+// no other listed word uses). make_tok() looks each core up once and stores the bitmask of
+// all its classes in Tok::cls, so a class test is a bit test whatever the list sizes.
+// Rule packs carry the same table, precomputed by the pack compiler (vox_rulepack.cpp).
+static constexpr const wchar_t* kTheWords[]   = { L"the" };
+static constexpr const wchar_t* kAndWords[]   = { L"and" };
+static constexpr const wchar_t* kIsWords[]    = { L"is" };
+static constexpr const wchar_t* kThePreps[]   = { L"to", L"for", L"of", L"in", L"on", L"at" };
+static constexpr const wchar_t* kStop[] = {
+    L"the",L"thee",L"a",L"an",L"to",L"for",L"of",L"in",L"on",L"at",L"by",L"with",L"from",
+    L"as",L"is",L"are",L"was",L"were",L"this",L"that"
+};
+static constexpr const wchar_t* kLightVerb[] = {
+    L"welcome",L"wait",L"stand",L"provide",L"provided",L"return",L"remain",L"maintain",
+    L"maintained",L"verify",L"contact",L"board",L"arriving",L"inbound",L"bound",
+    L"commence",L"commences"
+};
+static constexpr const wchar_t* kUnit[]       = { L"degrees", L"hours", L"percent", L"%" };
+static constexpr const wchar_t* kLinkers[]    = { L"at", L"in", L"on", L"to", L"of", L"for", L"from", L"by" };
+static constexpr const wchar_t* kDeterminers[] = {
+    L"the",L"thee",L"a",L"an",L"this",L"that",L"these",L"those",
+    L"some",L"any",L"each",L"every",L"no"
+};
+static constexpr const wchar_t* kAreaHeads[]  = { L"area", L"level", L"sector" };
+// Lead-in phrases (break after them); words before the last must be whole tokens
+static constexpr const wchar_t* kLeadins[] = {
+    L"now", L"please", L"a reminder", L"on behalf of",
+    L"good morning", L"good evening", L"this automated train", L"this tram"
+};
+
+struct WordList { const wchar_t* const* w; uint32_t n; uint16_t cls; };
+template<size_t N>
+static constexpr WordList wl(const wchar_t* const (&a)[N], uint16_t cls){ return WordList{ a, (uint32_t)N, cls }; }
+
+// in WordClass bit order (vox_word_class_name() follows the same order)
+static constexpr WordList kWordLists[] = {
+    wl(kTheWords, WC_THE), wl(kAndWords, WC_AND), wl(kIsWords, WC_IS), wl(kThePreps, WC_THEE_PREP),
+    wl(kStop, WC_STOP), wl(kLightVerb, WC_LIGHTVERB), wl(kUnit, WC_UNIT), wl(kLinkers, WC_LINKER),
+    wl(kDeterminers, WC_DETERMINER), wl(kAreaHeads, WC_AREA),
+};
+
+const char* vox_word_class_name(int bit){
+    static const char* const names[WC_COUNT] = {
+        "the", "and", "is", "thee_prep", "stop", "lightverb", "unit", "linker", "determiner", "area"
+    };
+    return (bit>=0 && bit<WC_COUNT) ? names[bit] : "?";
 }
 
+static constexpr uint32_t lit_len(const wchar_t* s){ uint32_t n=0; while(s[n]) ++n; return n; }
+static constexpr uint32_t lit_hash(const wchar_t* s){
+    uint32_t h = kVoxFnvBasis;
+    for(; *s; ++s){ h ^= (uint32_t)*s; h *= kVoxFnvPrime; }
+    return h;
+}
+static constexpr bool lit_eq(const wchar_t* a, const wchar_t* b){
+    for(; *a && *a==*b; ++a, ++b) {}
+    return *a==*b;
+}
+static constexpr uint32_t word_list_total(){
+    uint32_t n = 0;
+    for(const WordList& l : kWordLists) n += l.n;
+    return n;
+}
+static constexpr uint32_t builtin_pool_size(){
+    uint32_t n = 0;
+    for(const WordList& l : kWordLists) for(uint32_t i=0;i<l.n;++i) n += lit_len(l.w[i]);
+    for(const wchar_t* p : kLeadins) n += lit_len(p);
+    return n;
+}
 
-// “the” -> “thee”
-//  - Backward rule: after preps (to/for/of/in/on/at) or "on behalf of"
-//  - NEW Forward rule: before TitleCase, single letter (X or X:), or a number
-// Robust across \!br tags; preserves trailing punctuation.
-static void apply_thee_rule(std::wstring& s){
-    // tokenize by whitespace; keep tags as tokens
-    std::wstringstream ss(s);
-    std::vector<std::wstring> tok; std::wstring t;
-    while (ss >> t) tok.push_back(t);
-    if (tok.empty()) return;
-
-    auto is_tag = [](const std::wstring& w){
-        return (w==L"\\!br" || w==L"\\!wH1" || w==L"\\!wH0");
-    };
-    auto to_lower_copy = [](std::wstring v){ for (auto& c: v) c=(wchar_t)towlower(c); return v; };
-
-    // split trailing punctuation; return (core, punctTail)
-    auto split_tail = [](const std::wstring& x)->std::pair<std::wstring,std::wstring>{
-        std::wstring core=x, tail;
-        while (!core.empty()){
-            wchar_t c = core.back();
-            if (c==L','||c==L'.'||c==L';'||c==L':'||c==L'!'||c==L'?'||c==L'"'||c==L'\''){
-                tail.insert(tail.begin(), c);
-                core.pop_back();
-            } else break;
-        }
-        return {core, tail};
+static constexpr uint32_t kBuiltinSlots   = vox_slots_for(word_list_total());
+static constexpr uint32_t kBuiltinBuckets = vox_buckets_for(word_list_total());
+static constexpr uint32_t kBuiltinLeadins = (uint32_t)(sizeof(kLeadins)/sizeof(kLeadins[0]));
+
+struct BuiltinTable {
+    VoxWordSlot slot[kBuiltinSlots] = {};
+    uint32_t    disp[kBuiltinBuckets] = {};
+    uint16_t    pool[builtin_pool_size()] = {};
+    VoxPhrase   leadin[kBuiltinLeadins] = {};
+    bool        ok = false;
+};
+
+static constexpr BuiltinTable build_builtin_table(){
+    BuiltinTable t{};
+    uint32_t np = 0;
+    auto intern = [&](const wchar_t* w){
+        uint32_t off = np;
+        for(; *w; ++w) t.pool[np++] = (uint16_t)*w;
+        return off;
     };
+    // merge the lists: one entry per distinct word with the union of its classes
+    const wchar_t* word[word_list_total()] = {};
+    uint16_t cls[word_list_total()] = {};
+    uint32_t hash[word_list_total()] = {};
+    uint32_t n = 0;
+    for(const WordList& l : kWordLists){
+        for(uint32_t i=0;i<l.n;++i){
+            uint32_t k = 0;
+            while(k<n && !lit_eq(word[k], l.w[i])) ++k;
+            if(k==n){ word[n] = l.w[i]; hash[n] = lit_hash(l.w[i]); ++n; }
+            cls[k] = (uint16_t)(cls[k] | l.cls);
+        }
+    }
+    uint32_t slot_of[word_list_total()] = {};
+    bool used[kBuiltinSlots] = {};
+    uint32_t order[word_list_total()] = {};
+    if(!vox_place_words(hash, n, t.disp, kBuiltinBuckets, slot_of, used, kBuiltinSlots, order)) return t;
+    for(uint32_t k=0;k<n;++k)
+        t.slot[slot_of[k]] = VoxWordSlot{ intern(word[k]), (uint16_t)lit_len(word[k]), cls[k], hash[k] };
+    for(uint32_t i=0;i<kBuiltinLeadins;++i)
+        t.leadin[i] = VoxPhrase{ intern(kLeadins[i]), lit_len(kLeadins[i]) };
+    t.ok = true;
+    return t;
+}
+static constexpr BuiltinTable kBuiltin = build_builtin_table();
+static_assert(kBuiltin.ok, "built-in word-class table: no perfect hash found");
+
+static const VoxRules kBuiltinRules = {
+    "builtin",
+    kBuiltin.slot, kBuiltinSlots, kBuiltin.disp, kBuiltinBuckets, kBuiltin.pool,
+    kBuiltin.leadin, kBuiltinLeadins,
+    /*pause_cs*/ 500, /*max_beats*/ 3, /*heavy_syllables*/ 3, /*heavy_chars*/ 8, VR_ALL
+};
+const VoxRules& vox_builtin_rules(){ return kBuiltinRules; }
+
+// Classes of a lowercased core with FNV-1a hash `h`; 0 when it is in no list.
+static inline uint16_t word_class(const VoxRules& R, const wchar_t* p, uint32_t core, uint32_t h){
+    const VoxWordSlot& s = R.slots[vox_word_slot(h, R.disp[vox_word_bucket(h, R.bucket_count)], R.slot_count)];
+    if(s.len!=core || s.hash!=h) return 0;
+    const uint16_t* w = R.pool + s.off;
+    for(uint32_t k=0;k<core;++k) if((wchar_t)towlower(p[k])!=(wchar_t)w[k]) return 0;
+    return s.cls;
+}
 
-    auto clean_lower = [&](const std::wstring& x)->std::wstring{
-        auto p = split_tail(x);
-        return to_lower_copy(p.first);
-    };
-    auto bare = [&](const std::wstring& x)->std::wstring{
-        return split_tail(x).first;
-    };
+static inline bool is_tail_punct(wchar_t c){
+    return c==L','||c==L'.'||c==L';'||c==L':'||c==L'!'||c==L'?'||c==L'"'||c==L'\'';
+}
+static inline const wchar_t* tx(const Sentence& S, const Tok& t){ return S.buf.data() + t.off; }
+
+static inline bool text_is(const wchar_t* p, size_t n, const wchar_t* lit){
+    size_t k=0;
+    for(; k<n && lit[k]; ++k) if(p[k]!=lit[k]) return false;
+    return k==n && !lit[k];
+}
+static inline bool tok_is(const Sentence& S, const Tok& t, const wchar_t* lit){
+    return text_is(tx(S,t), t.len, lit);
+}
+
+// Classify a span of S.buf: trailing punctuation split, lowercase hash and tag kind.
+static Tok make_tok(const Sentence& S, size_t off, size_t len){
+    Tok t;
+    t.off = (uint32_t)off;
+    t.len = (uint32_t)len;
+    const wchar_t* p = S.buf.data() + off;
+    size_t core = len;
+    while(core>0 && is_tail_punct(p[core-1])) --core;
+    t.core = (uint32_t)core;
+    uint32_t h = kVoxFnvBasis;
+    for(size_t k=0;k<core;++k){ h ^= (uint32_t)towlower(p[k]); h *= kVoxFnvPrime; }
+    t.hash = h;
+    t.cls  = word_class(*S.R, p, t.core, h);
+    if(text_is(p,len,L"\\!br") || text_is(p,len,L"\\!wH1") || text_is(p,len,L"\\!wH0")) t.kind = TK_TAG;
+    return t;
+}
+static Tok add_tok(Sentence& S, const wchar_t* p, size_t n){
+    size_t off = S.buf.size();
+    S.buf.append(p, n);
+    return make_tok(S, off, n);
+}
+
+// Tokenize on whitespace (keep punctuation with token)
+static void tokenize(Sentence& S, const std::wstring& in, Span sent){
+    S.buf.assign(in, sent.a, sent.b-sent.a);
+    S.toks.clear();
+    size_t i=0, n=S.buf.size();
+    while(i<n){
+        while(i<n && iswspace(S.buf[i])) ++i;
+        if(i>=n) break;
+        size_t b=i;
+        while(i<n && !iswspace(S.buf[i])) ++i;
+        S.toks.push_back(make_tok(S, b, i-b));
+    }
+}
+
+
+static inline bool core_titlecase(const Sentence& S, const Tok& t){
+    const wchar_t* p = tx(S,t);
+    return t.core>0 && iswalpha(p[0]) && iswupper(p[0]);
+}
+static inline bool core_digits(const Sentence& S, const Tok& t){
+    const wchar_t* p = tx(S,t);
+    if(t.core==0) return false;
+    for(uint32_t k=0;k<t.core;++k) if(!iswdigit(p[k])) return false;
+    return true;
+}
+// C or C: (the colon is already outside the core)
+static inline bool core_single_letter(const Sentence& S, const Tok& t){
+    const wchar_t* p = tx(S,t);
+    return t.core==1 && iswalpha(p[0]) && iswupper(p[0]);
+}
+static bool starts_with_punct(const Sentence& S, const Tok& t){
+    wchar_t c = tx(S,t)[0];
+    return (c==L'.'||c==L','||c==L';'||c==L':'||c==L'!'||c==L'?'||c==L')');
+}
+static bool is_open_punct(const Sentence& S, const Tok& t){
+    wchar_t c = tx(S,t)[0]; return (c==L'('||c==L'"'||c==L'\'');
+}
+
+
+// ---- Scanner helpers ----
+// Character classes follow the regex defaults the rules were written against:
+// \d = iswdigit, \w = iswalnum or '_', icase = towlower on both sides.
+// Positions are token-relative; the space between two tokens always counts as non-word.
+static inline bool is_word_char(wchar_t c){ return c==L'_' || iswalnum(c); }
+static inline bool at_word_boundary(const wchar_t* p, size_t n, size_t i){
+    bool prev = (i>0 && is_word_char(p[i-1]));
+    bool cur  = (i<n && is_word_char(p[i]));
+    return prev != cur;
+}
+// Case-insensitive prefix match of the lowercase literal `lit`.
+static inline bool prefix_ci(const wchar_t* p, size_t n, const wchar_t* lit){
+    for(size_t k=0; lit[k]; ++k) if(k>=n || (wchar_t)towlower(p[k])!=lit[k]) return false;
+    return true;
+}
 
-    auto prev_word = [&](int i, int nth)->std::wstring{
-        for (int k=i-1; k>=0; --k){
-            if (is_tag(tok[k])) continue;
-            if (--nth==0) return clean_lower(tok[k]);
+// Rebuilds the token array while a rule rewrites it. put_src()/emit() extend the token being
+// assembled at the end of S.buf and a ' ' inside emit() closes it, the same as appending to a
+// space-separated string would; keep() passes an untouched token through.
+// Appending can reallocate S.buf: a rule reads everything it needs from the source text
+// before its first put_src()/emit(), or fetches it again through at() afterwards.
+struct TokBuilder {
+    Sentence&         S;
+    std::vector<Tok>& out;                        // S.spare
+    size_t            open = std::wstring::npos;   // S.buf offset of the token being assembled
+    Tok               src;                        // source token being scanned
+    size_t            from = 0;                   // first offset in src not yet written
+
+    explicit TokBuilder(Sentence& s): S(s), out(s.spare) { out.clear(); }
+    void begin(const Tok& t, size_t i){ src = t; from = i; }
+    wchar_t at(size_t i) const { return S.buf[src.off + i]; }   // source text, valid across appends
+    void put_src(size_t i, size_t n){
+        if(!n) return;
+        if(open==std::wstring::npos) open = S.buf.size();
+        S.buf.append(S.buf, src.off + i, n);
+    }
+    void flush(size_t i){ if(i>from) put_src(from, i-from); from = i; }
+    void emit(const wchar_t* lit){
+        for(; *lit; ++lit){
+            if(*lit==L' '){ cut(); continue; }
+            if(open==std::wstring::npos) open = S.buf.size();
+            S.buf.push_back(*lit);
         }
-        return L"";
-    };
-    auto next_word = [&](int i, int nth)->std::wstring{
-        for (int k=i+1; k<(int)tok.size(); ++k){
-            if (is_tag(tok[k])) continue;
-            if (--nth==0) return tok[k]; // not lowered; we want case info
+    }
+    void cut(){
+        if(open==std::wstring::npos) return;
+        out.push_back(make_tok(S, open, S.buf.size()-open));
+        open = std::wstring::npos;
+    }
+    void keep(const Tok& t){ cut(); out.push_back(t); }
+};
+
+// A rule tries a match at token k, offset i. On success it calls b.flush(i), writes the
+// replacement and reports where scanning resumes; resuming inside a later token means the
+// space in between was consumed, so that token's remaining text joins the current one.
+typedef bool (*TokRule)(Sentence& S, TokBuilder& b, size_t k, size_t i, size_t& nk, size_t& ni);
+// Cheap per-token prefilter: tokens it rejects cannot start a match and are kept whole.
+typedef bool (*TokFilter)(const wchar_t* p, size_t n);
+
+static void rewrite_tokens(Sentence& S, TokFilter candidate, TokRule rule){
+    TokBuilder b(S);
+    size_t k=0, i=0;
+    while(k < S.toks.size()){
+        const Tok t = S.toks[k];
+        if(i==0 && !candidate(tx(S,t), t.len)){ b.keep(t); ++k; continue; }
+        b.begin(t, i);
+        bool jumped = false;
+        while(i < t.len){
+            size_t nk=k, ni=i;
+            if(rule(S, b, k, i, nk, ni)){
+                if(nk!=k){ k=nk; i=ni; jumped=true; break; }
+                i = ni;
+                b.begin(t, i);
+                continue;
+            }
+            ++i;
         }
-        return L"";
-    };
+        if(jumped) continue;
+        b.flush(t.len);
+        b.cut();
+        ++k; i=0;
+    }
+    b.cut();
+    S.toks.swap(S.spare);
+}
 
-    auto is_prep = [&](const std::wstring& w)->bool{
-        std::wstring tl = to_lower_copy(w);
-        return (tl==L"to"||tl==L"for"||tl==L"of"||tl==L"in"||tl==L"on"||tl==L"at");
-    };
-    auto is_title = [&](const std::wstring& w)->bool{
-        auto b = bare(w);
-        return !b.empty() && iswalpha(b[0]) && iswupper(b[0]);
-    };
-    auto is_single_letter = [&](const std::wstring& w)->bool{
-        auto b = bare(w);
-        if (b.size()==1 && iswalpha(b[0]) && iswupper(b[0])) return true;
-        if (b.size()==2 && iswalpha(b[0]) && iswupper(b[0]) && b[1]==L':') return true;
-        return false;
+
+// Lead-in break after short opening phrases (VoxRules::leadins)
+static void apply_leadin_break(Sentence& S){
+    // words before the last must be whole tokens; the last one only needs a \b after it
+    const VoxRules& R = *S.R;
+    for(uint32_t li=0; li<R.leadin_count; ++li){
+        const uint16_t* w   = R.pool + R.leadins[li].off;
+        const uint16_t* end = w + R.leadins[li].len;
+        size_t k=0, cut_at=0;
+        bool ok = true;
+        for(;;){
+            size_t wl=0; while(w+wl<end && w[wl]!=L' ') ++wl;
+            if(k>=S.toks.size()){ ok=false; break; }
+            const Tok& t = S.toks[k];
+            const wchar_t* p = tx(S,t);
+            if(t.len<wl){ ok=false; break; }
+            for(size_t c=0;c<wl && ok;++c) if((wchar_t)towlower(p[c])!=(wchar_t)w[c]) ok=false;
+            if(!ok) break;
+            if(w+wl<end){
+                if(t.len!=wl){ ok=false; break; }
+                ++k; w += wl+1;
+                continue;
+            }
+            if(!at_word_boundary(p, t.len, wl)){ ok=false; break; }
+            cut_at = wl;
+            break;
+        }
+        if(!ok) continue;
+
+        // "<phrase> \!br <rest>": split the last phrase token after the phrase word
+        const Tok t = S.toks[k];
+        Tok parts[3]; size_t np=0;
+        parts[np++] = make_tok(S, t.off, cut_at);
+        parts[np++] = add_tok(S, L"\\!br", 4);
+        if(cut_at<t.len) parts[np++] = make_tok(S, t.off+cut_at, t.len-cut_at);
+        S.toks[k] = parts[0];
+        S.toks.insert(S.toks.begin()+k+1, parts+1, parts+np);
+        return;
+    }
+}
+
+
+// “the” -> “thee”
+//  - Backward rule: after preps (to/for/of/in/on/at) or "on behalf of"
+//  - NEW Forward rule: before TitleCase, single letter (X or X:), or a number
+// Robust across \!br tags; preserves trailing punctuation.
+static void apply_thee_rule(Sentence& S){
+    auto& tok = S.toks;
+
+    auto prev_word = [&](int i)->const Tok*{
+        for (int k=i-1; k>=0; --k) if (tok[k].kind!=TK_TAG) return &tok[k];
+        return nullptr;
     };
-    auto is_number = [&](const std::wstring& w)->bool{
-        auto b = bare(w);
-        if (b.empty()) return false;
-        for (wchar_t c: b) if (!iswdigit(c)) return false;
-        return true;
+    auto next_word = [&](int i)->const Tok*{
+        for (int k=i+1; k<(int)tok.size(); ++k) if (tok[k].kind!=TK_TAG) return &tok[k];
+        return nullptr;
     };
 
     for (int i=0; i<(int)tok.size(); ++i){
-        if (is_tag(tok[i])) continue;
-
-        auto [core, tail] = split_tail(tok[i]);
-        std::wstring cl = to_lower_copy(core);
-        if (cl != L"the") { tok[i] = core + tail; continue; }
+        if (tok[i].kind==TK_TAG || !(tok[i].cls & WC_THE)) continue;
 
+        // Backward (prepositions; "on behalf of" ends in one)
         bool make_thee = false;
-
-        // Backward (prepositions, incl. "on behalf of")
-        std::wstring p1 = prev_word(i, 1);
-        if (!p1.empty()){
-            if (is_prep(p1)) make_thee = true;
-            else if (to_lower_copy(p1) == L"of"){
-                std::wstring p2 = prev_word(i, 2);
-                std::wstring p3 = prev_word(i, 3);
-                if (to_lower_copy(p2)==L"behalf" && to_lower_copy(p3)==L"on") make_thee = true;
-            }
-        }
+        if (const Tok* p1 = prev_word(i)) make_thee = (p1->cls & WC_THEE_PREP) != 0;
 
         // Forward (before proper names / letters / numbers)
         if (!make_thee){
-            std::wstring n1 = next_word(i, 1);
-            if (!n1.empty()){
-                if (is_title(n1) || is_single_letter(n1) || is_number(n1)){
+            if (const Tok* n1 = next_word(i)){
+                if (core_titlecase(S,*n1) || core_single_letter(S,*n1) || core_digits(S,*n1)){
                     make_thee = true;
                 }
             }
         }
 
-        tok[i] = (make_thee ? L"thee" : core) + tail;
+        if (make_thee){
+            const Tok t = tok[i];
+            size_t off = S.buf.size();
+            S.buf += L"thee";
+            S.buf.append(S.buf, t.off + t.core, t.len - t.core);
+            tok[i] = make_tok(S, off, S.buf.size()-off);
+        }
     }
+}
+
+
+// ---- Times, degrees, and 3-digit decomposition ----
+
+// ---- Numbers, times, dates, currency ----
+// One rewrite pass handles every numeric format. At each number the lexer reads the whole run
+// once ("$1,250.50", "10-20%", "2024-03-15", "21st") into a shape key, one byte per element
+// (n = digit group, $ = currency sign, separators as written, % and o = ordinal suffix), and
+// the key picks the candidate formats from a table hashed at compile time. Adding a format is
+// one table entry; the per-number cost stays one scan plus one probe. Runs no format claims go
+// through the original per-position rules (rule_time12 ... rule_degrees) in their old order, so
+// text outside the table's formats comes out exactly as before.
 
-    // rebuild
-    std::wstring out;
-    for (size_t i=0;i<tok.size();++i){
-        if (!out.empty()) out.push_back(L' ');
-        out += tok[i];
+// "… degrees" right after a number that ends its token (the number is already written)
+static bool degrees_follow(const Sentence& S, size_t k, size_t end){
+    if(end!=S.toks[k].len || k+1>=S.toks.size()) return false;
+    const Tok& g = S.toks[k+1];
+    return prefix_ci(tx(S,g), g.len, L"degrees") && at_word_boundary(tx(S,g), g.len, 7);
+}
+static void emit_degrees(TokBuilder& b, size_t k, size_t& nk, size_t& ni){
+    b.emit(L" \\!br degrees \\!br");
+    nk = k+1; ni = 7;
+}
+
+// Three-digit non-round group: 105 -> "100 \!br and \!br 5" (leading zero of the rest dropped)
+static bool three_digit_form(const wchar_t* p){
+    return p[0]>=L'1' && p[0]<=L'9' && !(p[1]==L'0' && p[2]==L'0');
+}
+static void emit_int(TokBuilder& b, Span g){
+    const wchar_t d[3] = { b.at(g.a), g.b-g.a>1 ? b.at(g.a+1) : L'0', g.b-g.a>2 ? b.at(g.a+2) : L'0' };
+    if(g.b-g.a!=3 || !three_digit_form(d)){ b.put_src(g.a, g.b-g.a); return; }
+    b.put_src(g.a, 1);
+    b.emit(L"00 \\!br and \\!br ");
+    if(d[1]!=L'0') b.put_src(g.a+1, 1);
+    b.put_src(g.a+2, 1);
+}
+
+// 12h time like 8:47 AM / A.M. / PM … (eat any trailing dot after meridiem when a word follows)
+//   -> “8 \!br 47 \!br Ay: \!br M:”. The meridiem may be the next token; "M:" never keeps a
+//   period after it.
+static bool rule_time12(Sentence& S, TokBuilder& b, size_t k, size_t i, size_t& nk, size_t& ni){
+    const Tok& t = S.toks[k];
+    const wchar_t* p = tx(S,t);
+    const size_t n = t.len;
+    if(!iswdigit(p[i]) || !at_word_boundary(p, n, i)) return false;
+    size_t q = i;
+    while(q<n && iswdigit(p[q])) ++q;
+    if(q-i>2) return false;
+    const size_t hh_end = q;
+    if(q>=n || (p[q]!=L':' && p[q]!=L'.')) return false;
+    ++q;
+    if(q+2>n || !iswdigit(p[q]) || !iswdigit(p[q+1])) return false;
+    const size_t mm = q;
+    q += 2;
+
+    size_t mk = k, r = q;
+    const wchar_t* m = p; size_t mn = n;
+    if(q==n){
+        if(k+1>=S.toks.size()) return false;
+        mk = k+1; r = 0;
+        m = tx(S, S.toks[mk]); mn = S.toks[mk].len;
+    }
+    wchar_t ap = (wchar_t)towlower(m[r]);
+    if(ap!=L'a' && ap!=L'p') return false;
+    ++r;
+    if(r<mn && m[r]==L'.') ++r;
+    if(r>=mn || (wchar_t)towlower(m[r])!=L'm') return false;
+    ++r;
+    // up to two optional dots follow; take the longest run that still ends on a word boundary
+    size_t dots = 0;
+    while(dots<2 && r+dots<mn && m[r+dots]==L'.') ++dots;
+    while(!at_word_boundary(m, mn, r+dots)){
+        if(dots==0) return false;
+        --dots;
     }
-    s.swap(out);
+
+    nk = mk; ni = r+dots;
+    // one more period right after (or opening the next token) goes too
+    if(ni<mn && m[ni]==L'.') ++ni;
+    else if(ni==mn && mk+1<S.toks.size() && tx(S, S.toks[mk+1])[0]==L'.'){ nk = mk+1; ni = 1; }
+
+    b.flush(i);
+    b.put_src(i, hh_end-i);
+    b.emit(L" \\!br ");
+    b.put_src(mm, 2);
+    b.emit(ap==L'p' ? L" \\!br P: \\!br M:" : L" \\!br Ay: \\!br M:");
+    return true;
 }
 
+// “The time is 8 …” -> break before the hour
+static bool ends_with_he(const wchar_t* p, size_t n){ return n>=3 && p[n-2]==L'h' && p[n-1]==L'e'; }
+static bool rule_time_is(Sentence& S, TokBuilder& b, size_t k, size_t i, size_t& nk, size_t& ni){
+    const Tok& t = S.toks[k];
+    const wchar_t* p = tx(S,t);
+    if((p[i]!=L'T' && p[i]!=L't') || i+3!=t.len || p[i+1]!=L'h' || p[i+2]!=L'e') return false;
+    if(!at_word_boundary(p, t.len, i) || k+3>=S.toks.size()) return false;
+    if(!tok_is(S, S.toks[k+1], L"time") || !tok_is(S, S.toks[k+2], L"is")) return false;
+    if(!iswdigit(tx(S, S.toks[k+3])[0])) return false;
+
+    b.flush(t.len);
+    b.keep(S.toks[k+1]);
+    b.keep(S.toks[k+2]);
+    b.emit(L" \\!br ");
+    nk = k+3; ni = 0;
+    return true;
+}
 
-// Times, degrees, and 3-digit decomposition
-static void apply_time_numbers_degrees(std::wstring& s){
-    // 12h time like 8:47 AM / A.M. / PM … (eat any trailing dot after meridiem)
-    {
-        std::wregex t12(LR"(\b(\d{1,2})[:.](\d{2})\s*((?:A\.?M\.?)|(?:P\.?M\.?))(?:\.)?\b)", std::regex_constants::icase);
-        std::wstring out; out.reserve(s.size()+32);
-        std::wsregex_iterator it(s.begin(), s.end(), t12), end;
-        size_t last = 0;
-        for(; it!=end; ++it){
-            auto m = *it;
-            out.append(s, last, m.position()-last);
-            std::wstring hh = m.str(1);
-            std::wstring mm = m.str(2);
-            std::wstring ap = to_lower(m.str(3));
-            std::wstring ap1 = (ap[0]==L'p') ? L"P:" : L"Ay:";
-            out += hh + L" \\!br " + mm + L" \\!br " + ap1 + L" \\!br M:";
-            last = m.position() + m.length();
-        }
-        out.append(s, last, std::wstring::npos);
-        s.swap(out);
+// 24h “HH00 hours” -> “HH \!br hundred \!br hours”
+static bool rule_hours(Sentence& S, TokBuilder& b, size_t k, size_t i, size_t& nk, size_t& ni){
+    const Tok& t = S.toks[k];
+    const wchar_t* p = tx(S,t);
+    if(i+4!=t.len || !iswdigit(p[i]) || !iswdigit(p[i+1]) || p[i+2]!=L'0' || p[i+3]!=L'0') return false;
+    if(!at_word_boundary(p, t.len, i) || k+1>=S.toks.size()) return false;
+    const Tok& h = S.toks[k+1];
+    if(!prefix_ci(tx(S,h), h.len, L"hours") || !at_word_boundary(tx(S,h), h.len, 5)) return false;
+
+    b.flush(i);
+    b.put_src(i, 2);
+    b.emit(L" \\!br hundred \\!br hours");
+    nk = k+1; ni = 5;
+    return true;
+}
+
+// Three-digit non-round numbers (emit_int), then "degrees" if it follows
+static bool rule_three_digit(Sentence& S, TokBuilder& b, size_t k, size_t i, size_t& nk, size_t& ni){
+    const Tok& t = S.toks[k];
+    const wchar_t* p = tx(S,t);
+    if(i+3>t.len || !iswdigit(p[i+1]) || !iswdigit(p[i+2]) || !three_digit_form(p+i)) return false;
+    if(!at_word_boundary(p, t.len, i) || !at_word_boundary(p, t.len, i+3)) return false;
+
+    b.flush(i);
+    emit_int(b, Span{i, i+3});
+    if(degrees_follow(S, k, i+3)) emit_degrees(b, k, nk, ni);
+    else { nk = k; ni = i+3; }
+    return true;
+}
+
+// Degrees: “93 degrees” -> “93 \!br degrees \!br”
+static bool rule_degrees(Sentence& S, TokBuilder& b, size_t k, size_t i, size_t& nk, size_t& ni){
+    const Tok& t = S.toks[k];
+    const wchar_t* p = tx(S,t);
+    if(!iswdigit(p[i]) || !at_word_boundary(p, t.len, i)) return false;
+    size_t d = i;
+    while(d<t.len && iswdigit(p[d])) ++d;
+    if(!degrees_follow(S, k, d)) return false;
+
+    b.flush(d);
+    emit_degrees(b, k, nk, ni);
+    return true;
+}
+
+// Fix any lingering "M:." -> "M:" (meridiem shouldn’t carry a period), also "M: ."
+static bool rule_meridiem_dot(Sentence& S, TokBuilder& b, size_t k, size_t i, size_t& nk, size_t& ni){
+    const Tok& t = S.toks[k];
+    const wchar_t* p = tx(S,t);
+    if(p[i]!=L'M' || i+1>=t.len || p[i+1]!=L':') return false;
+    if(i+2<t.len){
+        if(p[i+2]!=L'.') return false;
+        nk = k; ni = i+3;
+    } else {
+        if(k+1>=S.toks.size() || tx(S, S.toks[k+1])[0]!=L'.') return false;
+        nk = k+1; ni = 1;
     }
-    // “The time is 8 …” -> break before the hour
-    s = std::regex_replace(s,
-        std::wregex(LR"((\b[Tt]he\s+time\s+is)\s+(\d+))"),
-        L"$1 \\!br $2");
+    b.flush(i);
+    b.emit(L"M:");
+    return true;
+}
 
-    // 24h “HH00 hours” -> “HH \!br hundred \!br hours”
-    s = std::regex_replace(s,
-        std::wregex(LR"(\b(\d{2})00\s+hours\b)", std::regex_constants::icase),
-        L"$1 \\!br hundred \\!br hours");
+// ---- numeric lexer ----
+static constexpr size_t kNumGroups = 4;   // digit groups kept for the formats (runs may be longer)
+
+struct NumLex {
+    size_t   start = 0, end = 0;   // [start,end) of the token text, suffix included
+    wchar_t  cur   = 0;            // currency sign, 0 if none
+    size_t   ng    = 0;            // digit groups seen
+    Span     g[kNumGroups];        // the first kNumGroups of them
+    char     sep[kNumGroups] = {}; // separator after each of those ('-' for an en dash too)
+    uint64_t key   = 0;            // shape, one byte per element; 0 when longer than 8
+};
+
+static inline bool is_currency(wchar_t c){ return c==L'$' || c==0x00A3 || c==0x20AC; }   // $ £ €
+static inline bool is_num_sep(wchar_t c){ return c==L':' || c==L'.' || c==L'-' || c==L'/' || c==0x2013; }
+static inline bool ends_word(const wchar_t* p, size_t n, size_t i){ return i>=n || !is_word_char(p[i]); }
+static bool is_ordinal_suffix(const wchar_t* p){
+    wchar_t a = (wchar_t)towlower(p[0]), b = (wchar_t)towlower(p[1]);
+    return (a==L's'&&b==L't') || (a==L'n'&&b==L'd') || (a==L'r'&&b==L'd') || (a==L't'&&b==L'h');
+}
 
-    // Three-digit non-round numbers: 105 -> “100 \!br and \!br 5” (strip leading zero in remainder)
-    {
-        std::wregex n3(LR"(\b([1-9])(\d)(\d)\b)");
-        std::wstring out; out.reserve(s.size()+32);
-        std::wsregex_iterator it(s.begin(), s.end(), n3), end;
-        size_t last = 0;
-        for(; it!=end; ++it){
-            auto m = *it;
-            std::wstring yz = m.str(2)+m.str(3);
-            if (yz == L"00") continue; // round, leave as-is
-            size_t nz = 0; while (nz < yz.size() && yz[nz]==L'0') ++nz;
-            std::wstring rem = yz.substr(nz);
-            out.append(s, last, m.position()-last);
-            out += m.str(1)+L"00 \\!br and \\!br " + (rem.empty()? yz : rem);
-            last = m.position() + m.length();
+static bool lex_number(const wchar_t* p, size_t n, size_t i, NumLex& L){
+    L = NumLex{};
+    L.start = i;
+    int len = 0;
+    auto push = [&](char c){ if(++len<=8) L.key = (L.key<<8) | (uint8_t)c; else L.key = 0; };
+    size_t q = i;
+    if(is_currency(p[q])){ L.cur = p[q]; push('$'); ++q; }
+    if(q>=n || !iswdigit(p[q])) return false;
+    for(;;){
+        size_t a = q;
+        while(q<n && iswdigit(p[q])) ++q;
+        // thousands separators in an amount: $1,250,000
+        if(L.cur && L.ng==0)
+            while(q+4<=n && p[q]==L',' && iswdigit(p[q+1]) && iswdigit(p[q+2]) && iswdigit(p[q+3])
+                  && (q+4==n || !iswdigit(p[q+4]))) q += 4;
+        if(L.ng<kNumGroups) L.g[L.ng] = Span{a, q};
+        ++L.ng;
+        push('n');
+        if(q+1<n && is_num_sep(p[q]) && iswdigit(p[q+1])){
+            const char c = (p[q]==0x2013) ? '-' : (char)p[q];
+            if(L.ng<=kNumGroups) L.sep[L.ng-1] = c;
+            push(c); ++q;
+            continue;
         }
-        out.append(s, last, std::wstring::npos);
-        s.swap(out);
+        break;
     }
+    if(q<n && p[q]==L'%'){ push('%'); ++q; }
+    else if(L.ng==1 && !L.cur && q+2<=n && is_ordinal_suffix(p+q) && ends_word(p, n, q+2)){ push('o'); q += 2; }
+    L.end = q;
+    return true;
+}
 
-    // Degrees: “93 degrees” -> “93 \!br degrees \!br”
-    s = std::regex_replace(s,
-        std::wregex(LR"(\b(\d+)\s+degrees\b)", std::regex_constants::icase),
-        L"$1 \\!br degrees \\!br");
+static unsigned num_value(const wchar_t* p, Span g){
+    unsigned v = 0;
+    for(size_t k=g.a; k<g.b; ++k) if(iswdigit(p[k])) v = (v>9999999u) ? v : v*10 + (unsigned)(p[k]-L'0');
+    return v;
+}
+static inline size_t glen(Span g){ return g.b-g.a; }
+
+// ---- words ----
+static constexpr const wchar_t* kOrdinals[20] = {
+    L"", L"first", L"second", L"third", L"fourth", L"fifth", L"sixth", L"seventh", L"eighth", L"ninth",
+    L"tenth", L"eleventh", L"twelfth", L"thirteenth", L"fourteenth", L"fifteenth", L"sixteenth",
+    L"seventeenth", L"eighteenth", L"nineteenth"
+};
+static constexpr const wchar_t* kTens[10] = {
+    L"", L"", L"twenty", L"thirty", L"forty", L"fifty", L"sixty", L"seventy", L"eighty", L"ninety"
+};
+static constexpr const wchar_t* kTensOrdinal[10] = {
+    L"", L"", L"twentieth", L"thirtieth", L"fortieth", L"fiftieth", L"sixtieth", L"seventieth",
+    L"eightieth", L"ninetieth"
+};
+static constexpr const wchar_t* kMonths[13] = {
+    L"", L"January", L"February", L"March", L"April", L"May", L"June", L"July", L"August",
+    L"September", L"October", L"November", L"December"
+};
+struct CurrencyWords { wchar_t sign; const wchar_t* one; const wchar_t* many; const wchar_t* sub_one; const wchar_t* sub_many; };
+static constexpr CurrencyWords kCurrencies[] = {
+    { L'$',           L" dollar", L" dollars", L" cent",  L" cents" },
+    { (wchar_t)0x00A3, L" pound",  L" pounds",  L" penny", L" pence" },
+    { (wchar_t)0x20AC, L" euro",   L" euros",   L" cent",  L" cents" },
+};
+static constexpr const wchar_t* kScales[] = { L"thousand", L"million", L"billion", L"trillion" };
+
+// 1..99 -> "first" … "ninety ninth"
+static void emit_ordinal_words(TokBuilder& b, unsigned v){
+    if(v<20) b.emit(kOrdinals[v]);
+    else if(v%10==0) b.emit(kTensOrdinal[v/10]);
+    else { b.emit(kTens[v/10]); b.emit(L" "); b.emit(kOrdinals[v%10]); }
+}
 
-    // Fix any lingering "M:." -> "M:" (meridiem shouldn’t carry a period)
-    s = std::regex_replace(s, std::wregex(LR"(M:\s*\.)"), L"M:");
+// Integer group, or "A \!br point \!br 1 4" when a fraction group follows
+static void emit_number(TokBuilder& b, Span whole, const Span* frac){
+    emit_int(b, whole);
+    if(!frac) return;
+    b.emit(L" \\!br point \\!br ");
+    for(size_t k=frac->a; k<frac->b; ++k){
+        if(k>frac->a) b.emit(L" ");
+        b.put_src(k, 1);
+    }
 }
 
+// ---- formats ----
+// Each gets the lexed run (L.start at a word start, L.end at a word end) and returns false to
+// pass it on to the next format for the same shape.
+typedef bool (*NumRule)(Sentence& S, TokBuilder& b, size_t k, const NumLex& L, size_t& nk, size_t& ni);
 
-// Syllable heuristic
-static int syllables(const std::wstring& w){
-    if(w.empty()) return 0;
-    std::wstring s; s.reserve(w.size());
-    for(wchar_t c: w) s.push_back((wchar_t)towlower(c));
-    auto isv=[&](wchar_t c){ return c==L'a'||c==L'e'||c==L'i'||c==L'o'||c==L'u'||c==L'y'; };
-    int count=0; bool in=false;
-    for(wchar_t c: s){ if(isv(c)){ if(!in){ ++count; in=true; } } else in=false; }
-    if(count>1 && s.size()>1 && s.back()==L'e' && !(s.size()>2 && s[s.size()-2]==L'l')) --count; // silent 'e' (not "...le")
-    if(s.size()>2 && s.back()==L'e' && s[s.size()-2]==L'l') ++count; // “…le”
-    return std::max(1,count);
+static bool num_done(Sentence& S, TokBuilder& b, size_t k, size_t end, size_t& nk, size_t& ni){
+    if(degrees_follow(S, k, end)) emit_degrees(b, k, nk, ni);
+    else { nk = k; ni = end; }
+    return true;
 }
 
-enum Wt { LIGHT, MEDIUM, HEAVY };
+// 8:47 PM (the original rule)
+static bool num_time12(Sentence& S, TokBuilder& b, size_t k, const NumLex& L, size_t& nk, size_t& ni){
+    return rule_time12(S, b, k, L.start, nk, ni);
+}
 
-static bool is_stop(const std::wstring& tl){
-    static const wchar_t* sw[] = {
-        L"the",L"thee",L"a",L"an",L"to",L"for",L"of",L"in",L"on",L"at",L"by",L"with",L"from",
-        L"as",L"is",L"are",L"was",L"were",L"this",L"that"
-    };
-    for(auto* w: sw) if(tl==w) return true;
-    return false;
+// 14:30 -> "14 \!br 30"; 14:00 -> "14 \!br hundred \!br hours"; 9:00 -> "9 o'clock"
+static bool num_clock(Sentence& S, TokBuilder& b, size_t k, const NumLex& L, size_t& nk, size_t& ni){
+    const Tok& t = S.toks[k];
+    const wchar_t* p = tx(S,t);
+    const Span h = L.g[0], m = L.g[1];
+    const unsigned mv = num_value(p,m);
+    if(glen(h)>2 || glen(m)!=2 || num_value(p,h)>23 || mv>59) return false;
+    b.flush(L.start);
+    b.put_src(h.a, glen(h));
+    if(mv!=0){
+        b.emit(L" \\!br ");
+        b.put_src(m.a, 2);
+        nk = k; ni = L.end;
+    } else if(glen(h)==2){
+        b.emit(L" \\!br hundred \\!br hours");
+        nk = k; ni = L.end;
+        if(L.end==t.len && k+1<S.toks.size()){   // "14:00 hours": don't say it twice
+            const Tok& x = S.toks[k+1];
+            if(prefix_ci(tx(S,x), x.len, L"hours") && at_word_boundary(tx(S,x), x.len, 5)){ nk = k+1; ni = 5; }
+        }
+    } else {
+        b.emit(L" o'clock");
+        nk = k; ni = L.end;
+    }
+    return true;
 }
-static bool is_lightverb(const std::wstring& tl){
-    static const wchar_t* vw[] = {
-        L"welcome",L"wait",L"stand",L"provide",L"provided",L"return",L"remain",L"maintain",
-        L"maintained",L"verify",L"contact",L"board",L"arriving",L"inbound",L"bound",
-        L"commence",L"commences"
-    };
-    for(auto* w: vw) if(tl==w) return true;
-    return false;
+
+// 98.6 -> "98 \!br point \!br 6"
+static bool num_decimal(Sentence& S, TokBuilder& b, size_t k, const NumLex& L, size_t& nk, size_t& ni){
+    b.flush(L.start);
+    emit_number(b, L.g[0], &L.g[1]);
+    return num_done(S, b, k, L.end, nk, ni);
 }
-static bool is_unit(const std::wstring& tl){
-    static const wchar_t* uw[] = { L"degrees", L"hours", L"percent", L"%" };
-    for(auto* w: uw) if(tl==w) return true;
+
+// 21st -> "twenty first"; 105th -> "100 \!br and \!br fifth"; 300th -> "3 hundredth"
+static bool num_ordinal(Sentence& S, TokBuilder& b, size_t k, const NumLex& L, size_t& nk, size_t& ni){
+    const wchar_t* p = tx(S, S.toks[k]);
+    const Span g = L.g[0];
+    const unsigned v = num_value(p, g);
+    if(glen(g)>3 || v==0) return false;
+    b.flush(L.start);
+    if(v>=100){
+        b.put_src(g.b-3, 1);
+        if(v%100==0){ b.emit(L" hundredth"); nk = k; ni = L.end; return true; }
+        b.emit(L"00 \\!br and \\!br ");
+    }
+    emit_ordinal_words(b, v%100);
+    nk = k; ni = L.end;
+    return true;
+}
+
+// Groups [first,last] as one quantity: "N" or "N.F"; false for anything else
+static bool emit_quantity(TokBuilder& b, const NumLex& L, size_t first, size_t last){
+    if(first==last){ emit_int(b, L.g[first]); return true; }
+    if(last==first+1 && L.sep[first]=='.'){ emit_number(b, L.g[first], &L.g[last]); return true; }
     return false;
 }
+// Plain, decimal or range run: at most one '-', each side "N" or "N.F" (555-1234 is a phone
+// number, not a range)
+static bool amount_shape_ok(const NumLex& L){
+    if(L.ng>kNumGroups) return false;
+    size_t dashes = 0;
+    for(size_t j=0; j+1<L.ng; ++j){
+        if(L.sep[j]=='-') ++dashes;
+        else if(L.sep[j]!='.') return false;
+    }
+    if(dashes>1) return false;
+    for(size_t j=0; j+2<L.ng; ++j) if(L.sep[j]=='.' && L.sep[j+1]=='.') return false;
+    return !(L.ng==2 && L.sep[0]=='-' && glen(L.g[0])==3 && glen(L.g[1])==4);
+}
+// Body of a run that passed amount_shape_ok (everything before any % sign)
+static void emit_amount_body(TokBuilder& b, const NumLex& L){
+    size_t dash = L.ng;
+    for(size_t j=0; j+1<L.ng; ++j) if(L.sep[j]=='-') dash = j;
+    if(dash==L.ng){ emit_quantity(b, L, 0, L.ng-1); return; }
+    emit_quantity(b, L, 0, dash);
+    b.emit(L" \\!br to \\!br ");
+    emit_quantity(b, L, dash+1, L.ng-1);
+}
 
-static Wt weight(const std::wstring& tok){
-    if(tok.empty()) return LIGHT;
-    std::wstring pfree = strip_trailing_punct(tok);
-    std::wstring tl = to_lower(pfree);
-    if(is_stop(tl) || is_lightverb(tl)) return LIGHT;
-    if(is_all_digits(pfree)) return HEAVY;
-    if(pfree.find(L'-')!=std::wstring::npos) return HEAVY;
-    if(is_titlecase_word(pfree)) return HEAVY;
-    if(is_unit(tl)) return HEAVY;
-    int syl = syllables(pfree);
-    if(syl>=3 || pfree.size()>=8) return HEAVY; // long or many-syllable content words
-    return MEDIUM;
-}
-
-static bool is_and(const std::wstring& t){ return to_lower(strip_trailing_punct(t))==L"and"; }
-static bool starts_with_punct(const std::wstring& t){
-    if(t.empty()) return false;
-    wchar_t c = t.front();
-    return (c==L'.'||c==L','||c==L';'||c==L':'||c==L'!'||c==L'?'||c==L')');
+// 10-20, 1.5–2.5 -> "10 \!br to \!br 20"
+static bool num_range(Sentence& S, TokBuilder& b, size_t k, const NumLex& L, size_t& nk, size_t& ni){
+    if(!amount_shape_ok(L)) return false;
+    b.flush(L.start);
+    emit_amount_body(b, L);
+    return num_done(S, b, k, L.end, nk, ni);
 }
-static bool is_open_punct(const std::wstring& t){
-    if(t.empty()) return false;
-    wchar_t c=t.front(); return (c==L'('||c==L'"'||c==L'\'');
+
+// 50%, 2.5%, 10-20% -> "… percent"
+static bool num_percent(Sentence&, TokBuilder& b, size_t k, const NumLex& L, size_t& nk, size_t& ni){
+    if(!amount_shape_ok(L)) return false;
+    b.flush(L.start);
+    emit_amount_body(b, L);
+    b.emit(L" percent");
+    nk = k; ni = L.end;
+    return true;
 }
 
-// Tokenize on whitespace (keep punctuation with token)
-static std::vector<std::wstring> tokenize_ws(const std::wstring& s){
-    std::wstringstream ss(s);
-    std::vector<std::wstring> v; std::wstring t;
-    while(ss >> t) v.push_back(t);
-    return v;
+// $5 -> "5 dollars"; $5.50 -> "5 dollars \!br and \!br 50 cents"; $1.5 million -> "1 \!br point
+// \!br 5 million dollars"; $5-10 -> "5 \!br to \!br 10 dollars". Also £ and €.
+static bool num_currency(Sentence& S, TokBuilder& b, size_t k, const NumLex& L, size_t& nk, size_t& ni){
+    const Tok& t = S.toks[k];
+    const wchar_t* p = tx(S,t);
+    const CurrencyWords* cw = nullptr;
+    for(const CurrencyWords& c : kCurrencies) if(c.sign==L.cur) cw = &c;
+    if(!cw || !amount_shape_ok(L)) return false;
+
+    // "$5 million": the scale word moves in front of the unit
+    const wchar_t* scale = nullptr;
+    size_t scale_core = 0;
+    if(L.end==t.len && k+1<S.toks.size()){
+        const Tok& x = S.toks[k+1];
+        for(const wchar_t* sc : kScales)
+            if(x.core==lit_len(sc) && prefix_ci(tx(S,x), x.len, sc)){ scale = sc; scale_core = x.core; }
+    }
+    const bool cents = !scale && L.ng==2 && L.sep[0]=='.' && glen(L.g[1])==2;
+    const Span whole = L.g[0];
+    const bool one = !scale && glen(whole)==1 && p[whole.a]==L'1' && L.ng==(cents ? 2u : 1u);
+    const Span c = L.g[1];
+    const unsigned v = cents ? num_value(p, c) : 0;
+    const bool lead0 = cents && p[c.a]==L'0';
+
+    b.flush(L.start);
+    if(cents) emit_int(b, whole);
+    else emit_amount_body(b, L);
+    if(scale){ b.emit(L" "); b.emit(scale); }
+    b.emit(one ? cw->one : cw->many);
+    if(cents){
+        if(v){
+            b.emit(L" \\!br and \\!br ");
+            if(lead0) b.put_src(c.a+1, 1); else b.put_src(c.a, 2);
+            b.emit(v==1 ? cw->sub_one : cw->sub_many);
+        }
+    }
+    if(scale){ nk = k+1; ni = scale_core; }
+    else { nk = k; ni = L.end; }
+    return true;
+}
+
+// Month name, ordinal day and year: "March \!br fifteenth \!br 2024"
+static void emit_date(TokBuilder& b, unsigned month, unsigned day, Span year){
+    b.emit(kMonths[month]);
+    b.emit(L" \\!br ");
+    emit_ordinal_words(b, day);
+    b.emit(L" \\!br ");
+    b.put_src(year.a, glen(year));
+}
+static inline bool valid_md(unsigned m, unsigned d){ return m>=1 && m<=12 && d>=1 && d<=31; }
+
+// 2024-03-15
+static bool num_date_iso(Sentence& S, TokBuilder& b, size_t k, const NumLex& L, size_t& nk, size_t& ni){
+    const wchar_t* p = tx(S, S.toks[k]);
+    if(glen(L.g[0])!=4 || glen(L.g[1])>2 || glen(L.g[2])>2) return false;
+    const unsigned m = num_value(p, L.g[1]), d = num_value(p, L.g[2]);
+    if(!valid_md(m, d)) return false;
+    b.flush(L.start);
+    emit_date(b, m, d, L.g[0]);
+    nk = k; ni = L.end;
+    return true;
+}
+
+// 3/15/2024 (month first unless the first field can only be a day: 15/3/2024)
+static bool num_date_slash(Sentence& S, TokBuilder& b, size_t k, const NumLex& L, size_t& nk, size_t& ni){
+    const wchar_t* p = tx(S, S.toks[k]);
+    if(glen(L.g[0])>2 || glen(L.g[1])>2 || (glen(L.g[2])!=2 && glen(L.g[2])!=4)) return false;
+    unsigned m = num_value(p, L.g[0]), d = num_value(p, L.g[1]);
+    if(!valid_md(m, d)) std::swap(m, d);
+    if(!valid_md(m, d)) return false;
+    b.flush(L.start);
+    emit_date(b, m, d, L.g[2]);
+    nk = k; ni = L.end;
+    return true;
+}
+
+// ---- format table ----
+struct NumFormat { const char* shape; NumRule rule; };
+// Entries for one shape are adjacent and tried in order.
+static constexpr NumFormat kNumFormats[] = {
+    { "n:n",     num_time12     },
+    { "n:n",     num_clock      },
+    { "n.n",     num_time12     },
+    { "n.n",     num_decimal    },
+    { "no",      num_ordinal    },
+    { "n-n",     num_range      },
+    { "n.n-n",   num_range      },
+    { "n-n.n",   num_range      },
+    { "n.n-n.n", num_range      },
+    { "n%",      num_percent    },
+    { "n.n%",    num_percent    },
+    { "n-n%",    num_percent    },
+    { "$n",      num_currency   },
+    { "$n.n",    num_currency   },
+    { "$n-n",    num_currency   },
+    { "n-n-n",   num_date_iso   },
+    { "n/n/n",   num_date_slash },
+};
+static constexpr uint32_t kNumFormatCount = (uint32_t)(sizeof(kNumFormats)/sizeof(kNumFormats[0]));
+
+static constexpr uint64_t shape_key(const char* s){
+    uint64_t k = 0;
+    for(; *s; ++s) k = (k<<8) | (uint8_t)*s;
+    return k;
+}
+static constexpr uint32_t kShapeSlots = vox_pow2_at_least(2*kNumFormatCount);
+static constexpr uint32_t shape_slot(uint64_t key){ return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 40) & (kShapeSlots-1); }
+
+// Open addressing, built at compile time: key -> first entry + count
+struct ShapeTable {
+    uint64_t key[kShapeSlots]   = {};
+    uint8_t  first[kShapeSlots] = {};
+    uint8_t  count[kShapeSlots] = {};
+    bool     ok = true;
+};
+static constexpr ShapeTable build_shape_table(){
+    ShapeTable T{};
+    for(uint32_t f=0; f<kNumFormatCount; ++f){
+        const uint64_t key = shape_key(kNumFormats[f].shape);
+        uint32_t s = shape_slot(key);
+        while(T.key[s] && T.key[s]!=key) s = (s+1) & (kShapeSlots-1);
+        if(T.key[s]==key){
+            if(T.first[s] + T.count[s] != f) T.ok = false;   // same shape must be adjacent
+            ++T.count[s];
+        } else {
+            T.key[s] = key; T.first[s] = (uint8_t)f; T.count[s] = 1;
+        }
+    }
+    return T;
+}
+static constexpr ShapeTable kShapes = build_shape_table();
+static_assert(kShapes.ok, "kNumFormats: entries for one shape must be adjacent");
+
+// Runs no format claimed: the per-position rules at each group start, in their original order.
+static bool legacy_numbers(Sentence& S, TokBuilder& b, size_t k, const NumLex& L, size_t& nk, size_t& ni){
+    const Tok& t = S.toks[k];
+    size_t resume = L.end;
+    for(size_t i=L.start; i<L.end; ++i){
+        const wchar_t* p = tx(S,t);   // the rules below append to S.buf
+        if(!iswdigit(p[i]) || !at_word_boundary(p, t.len, i)) continue;
+        size_t jk = k, ji = i;
+        if(!rule_time12(S,b,k,i,jk,ji) && !rule_hours(S,b,k,i,jk,ji) &&
+           !rule_three_digit(S,b,k,i,jk,ji) && !rule_degrees(S,b,k,i,jk,ji)) continue;
+        if(jk!=k){ nk = jk; ni = ji; return true; }
+        b.begin(t, ji);
+        resume = std::max(resume, ji);
+        i = ji-1;
+    }
+    b.flush(resume);
+    nk = k; ni = resume;
+    return true;
 }
 
+static bool rule_numbers(Sentence& S, TokBuilder& b, size_t k, size_t i, size_t& nk, size_t& ni){
+    const Tok& t = S.toks[k];
+    const wchar_t* p = tx(S,t);
+    const wchar_t c = p[i];
+    if(c==L'T' || c==L't') return rule_time_is(S, b, k, i, nk, ni);
+    if(c==L'M') return rule_meridiem_dot(S, b, k, i, nk, ni);
+    if(iswdigit(c)){ if(!at_word_boundary(p, t.len, i)) return false; }
+    else if(!is_currency(c) || (i>0 && is_word_char(p[i-1]))) return false;
+
+    NumLex L;
+    if(!lex_number(p, t.len, i, L)) return false;
+    if(L.key && ends_word(p, t.len, L.end)){
+        uint32_t s = shape_slot(L.key);
+        while(kShapes.key[s] && kShapes.key[s]!=L.key) s = (s+1) & (kShapeSlots-1);
+        if(kShapes.key[s]==L.key)
+            for(uint32_t f=kShapes.first[s]; f<kShapes.first[s]+kShapes.count[s]; ++f)
+                if(kNumFormats[f].rule(S, b, k, L, nk, ni)) return true;
+    }
+    return legacy_numbers(S, b, k, L, nk, ni);
+}
+
+static bool numeric_candidate(const wchar_t* p, size_t n){
+    for(size_t k=0;k<n;++k) if(iswdigit(p[k]) || p[k]==L'M') return true;
+    return ends_with_he(p, n);
+}
+
+static void apply_time_numbers_degrees(Sentence& S){
+    rewrite_tokens(S, numeric_candidate, rule_numbers);
+}
+
+
+// Syllable heuristic
+static int syllables(const wchar_t* w, size_t n){
+    if(n==0) return 0;
+    auto isv=[&](wchar_t c){ return c==L'a'||c==L'e'||c==L'i'||c==L'o'||c==L'u'||c==L'y'; };
+    auto lc =[&](size_t k){ return (wchar_t)towlower(w[k]); };
+    int count=0; bool in=false;
+    for(size_t k=0;k<n;++k){ if(isv(lc(k))){ if(!in){ ++count; in=true; } } else in=false; }
+    if(count>1 && n>1 && lc(n-1)==L'e' && !(n>2 && lc(n-2)==L'l')) --count; // silent 'e' (not "...le")
+    if(n>2 && lc(n-1)==L'e' && lc(n-2)==L'l') ++count; // “…le”
+    return std::max(1,count);
+}
+int vox_syllables(const wchar_t* w, size_t n){ return syllables(w, n); }
+static int syllables(const Sentence& S, Tok& t){
+    if(t.syl < 0) t.syl = (int8_t)std::min(syllables(tx(S,t), t.core), 127);
+    return t.syl;
+}
+
+static Wt weight(const Sentence& S, Tok& t){
+    if(t.wt >= 0) return (Wt)t.wt;
+    const wchar_t* p = tx(S,t);
+    Wt w;
+    if(t.cls & (WC_STOP|WC_LIGHTVERB)) w = LIGHT;
+    else if(core_digits(S,t)) w = HEAVY;
+    else if(std::find(p, p+t.core, L'-')!=p+t.core) w = HEAVY;
+    else if(core_titlecase(S,t)) w = HEAVY;
+    else if(t.cls & WC_UNIT) w = HEAVY;
+    else if(syllables(S,t)>=S.R->heavy_syllables || t.core>=S.R->heavy_chars) w = HEAVY; // long or many-syllable content words
+    else w = MEDIUM;
+    t.wt = (int8_t)w;
+    return w;
+}
+
+
+// Output side of build_beats(). Behaves like appending to a string: sp() writes a space and
+// add() appends text, which glues onto the previous token unless a space came first.
+struct BeatOut {
+    Sentence&         S;
+    std::vector<Tok>& toks;                 // S.spare
+    bool              lead_space = false;   // output began with a space
+    bool              spaced     = false;   // a space follows the last token
+
+    explicit BeatOut(Sentence& s): S(s), toks(s.spare) { toks.clear(); }
+    bool empty() const { return toks.empty() && !lead_space; }
+    // output ends with " \!br"
+    bool ends_with_br() const {
+        return !toks.empty() && !spaced && tok_is(S, toks.back(), L"\\!br") && (toks.size()>1 || lead_space);
+    }
+    void sp(){ if(toks.empty()) lead_space = true; spaced = true; }
+    void add(const Tok& t){
+        if(toks.empty() || spaced){ toks.push_back(t); spaced = false; return; }
+        const Tok prev = toks.back();
+        size_t off = S.buf.size();
+        S.buf.append(S.buf, prev.off, prev.len);
+        S.buf.append(S.buf, t.off, t.len);
+        toks.back() = make_tok(S, off, prev.len + t.len);
+    }
+    void add(const wchar_t* lit){ add(add_tok(S, lit, wcslen(lit))); }
+    void br(){ sp(); add(L"\\!br"); }
+};
+
 // Insert TitleCase run breaks and Area/Level/Sector blocks
-static void emit_titlecase_run(const std::vector<std::wstring>& v, size_t i, size_t j, std::wstring& out){
+static void emit_titlecase_run(const std::vector<Tok>& v, size_t i, size_t j, BeatOut& out){
     // place a break before the run
-    if(!out.empty() && !ends_with_br(out)) out += L" \\!br";
+    if(!out.empty() && !out.ends_with_br()) out.br();
     for(size_t k=i;k<j;++k){
-        out += L" " + v[k] + L" \\!br";
+        out.sp(); out.add(v[k]); out.br();
     }
 }
 
@@ -336,11 +1249,14 @@ static void emit_titlecase_run(const std::vector<std::wstring>& v, size_t i, siz
 //        heavy-gate, 3-beat limiter.
 // NEW:   Split hyphenated/en-dash/em-dash compounds into parts with breaks.
 //        Standalone -, –, — act as hard breaks (not spoken).
-static std::wstring build_beats(const std::wstring& sentence){
-    auto v = tokenize_ws(sentence);
-    if(v.empty()) return sentence;
-
-    std::wstring out;
+static void build_beats(Sentence& S){
+    std::vector<Tok>& v = S.toks;
+    if(v.empty()) return;
+    const bool linkers   = (S.R->flags & VR_LINKERS) != 0;
+    const bool copula    = (S.R->flags & VR_COPULA) != 0;
+    const int  max_beats = S.R->max_beats;
+
+    BeatOut out(S);
     bool since_break_all_light = true;
     Wt   prev_w = LIGHT;
     int  content_run = 0; // consecutive MEDIUM/HEAVY since last break
@@ -351,62 +1267,42 @@ static std::wstring build_beats(const std::wstring& sentence){
         prev_w = LIGHT;
     };
 
-    auto bare = [](const std::wstring& w){ return strip_trailing_punct(w); };
-    auto is_area_head = [&](const std::wstring& w){ return w==L"Area"||w==L"Level"||w==L"Sector"; };
-    auto is_tag = [&](const std::wstring& w){ return (w==L"\\!br" || w==L"\\!wH1" || w==L"\\!wH0"); };
-    auto lower = [&](std::wstring s){ return to_lower(std::move(s)); };
-
-    auto is_single_letter = [&](const std::wstring& w)->bool{
-        std::wstring b = bare(w);
-        if (b.size()==1 && iswalpha(b[0]) && iswupper(b[0])) return true;          // C
-        if (b.size()==2 && iswalpha(b[0]) && iswupper(b[0]) && b[1]==L':') return true; // C:
-        return false;
-    };
-
-    // split trailing punctuation; return (core, punctTail)
-    auto split_tail = [](const std::wstring& x)->std::pair<std::wstring,std::wstring>{
-        std::wstring core=x, tail;
-        while (!core.empty()){
-            wchar_t c = core.back();
-            if (c==L','||c==L'.'||c==L';'||c==L':'||c==L'!'||c==L'?'||c==L'"'||c==L'\''){
-                tail.insert(tail.begin(), c);
-                core.pop_back();
-            } else break;
-        }
-        return {core, tail};
+    auto is_area_head = [&](const Tok& t){
+        return (t.cls & WC_AREA) && (tok_is(S,t,L"Area") || tok_is(S,t,L"Level") || tok_is(S,t,L"Sector"));
     };
+    auto is_dash = [](wchar_t c){ return c==L'-' || c==0x2013 /*–*/ || c==0x2014 /*—*/; };
 
     // emit hyphen/dash-split parts with breaks between them; keep tail on last part
-    auto emit_dash_split = [&](const std::wstring& tok)->bool{
-        auto [core, tail] = split_tail(tok);
+    auto emit_dash_split = [&](const Tok& tok)->bool{
+        const wchar_t* core = tx(S,tok);
+        const size_t n = tok.core;
         // find internal separators
-        std::vector<size_t> cuts;
-        for(size_t p=0;p<core.size();++p){
-            wchar_t c = core[p];
-            if (c==L'-' || c==0x2013 /*–*/ || c==0x2014 /*—*/){
+        size_t cuts = 0;
+        for(size_t p=0;p<n;++p){
+            if (is_dash(core[p])){
                 // only split if letters on both sides (avoid leading/trailing)
-                if (p>0 && p+1<core.size() && iswalpha(core[p-1]) && iswalpha(core[p+1]))
-                    cuts.push_back(p);
+                if (p>0 && p+1<n && iswalpha(core[p-1]) && iswalpha(core[p+1]))
+                    ++cuts;
                 else
                     return false; // treat as punctuation case elsewhere
             }
         }
-        if (cuts.empty()) return false;
+        if (cuts==0) return false;
 
         size_t start = 0;
-        for(size_t idx=0; idx<=cuts.size(); ++idx){
-            size_t end = (idx<cuts.size() ? cuts[idx] : core.size());
-            std::wstring part = core.substr(start, end-start);
-            // spacing before part
-            if(!out.empty() && !ends_with_br(out) && !starts_with_punct(part) && !is_open_punct(part))
-                out.push_back(L' ');
+        for(size_t idx=0; idx<=cuts; ++idx){
+            size_t end = start;
+            while(end<n && !is_dash(S.buf[tok.off+end])) ++end;
             // last part gets the tail
-            if (idx == cuts.size()) part += tail;
-            out += part;
+            Tok part = make_tok(S, tok.off+start, (idx==cuts ? tok.len : end) - start);
+            // spacing before part
+            if(!out.empty() && !out.ends_with_br() && !starts_with_punct(S,part) && !is_open_punct(S,part))
+                out.sp();
+            out.add(part);
             // break after each part
-            if(!ends_with_br(out)) out += L" \\!br";
+            if(!out.ends_with_br()) out.br();
             reset_after_break();
-            start = end + (idx<cuts.size() ? 1 : 0);
+            start = end + 1;
         }
         return true;
     };
@@ -416,8 +1312,7 @@ static std::wstring build_beats(const std::wstring& sentence){
         if (is_area_head(v[i])){
             size_t j=i+1;
             while(j<v.size()){
-                std::wstring wj = bare(v[j]);
-                if(is_all_digits(wj) || is_titlecase_word(wj)) ++j;
+                if(core_digits(S,v[j]) || core_titlecase(S,v[j])) ++j;
                 else break;
             }
             if(j>i+1){
@@ -427,9 +1322,9 @@ static std::wstring build_beats(const std::wstring& sentence){
                 continue;
             }
         }
-        if (is_titlecase_word(bare(v[i]))){
+        if (core_titlecase(S,v[i])){
             size_t j=i;
-            while(j<v.size() && is_titlecase_word(bare(v[j]))) ++j;
+            while(j<v.size() && core_titlecase(S,v[j])) ++j;
             if(j>=i+2){
                 emit_titlecase_run(v,i,j,out);
                 i=j;
@@ -439,12 +1334,12 @@ static std::wstring build_beats(const std::wstring& sentence){
         }
 
         // ---- "and" between heavier items ----
-        if(is_and(v[i]) && i>0 && i+1<v.size()){
-            Wt lw = weight(v[i-1]);
-            Wt rw = weight(v[i+1]);
+        if((v[i].cls & WC_AND) && i>0 && i+1<v.size()){
+            Wt lw = weight(S,v[i-1]);
+            Wt rw = weight(S,v[i+1]);
             if(lw>=MEDIUM && rw>=MEDIUM){
-                if(!ends_with_br(out)) out += L" \\!br";
-                out += L" and \\!br";
+                if(!out.ends_with_br()) out.br();
+                out.sp(); out.add(L"and"); out.br();
                 ++i;
                 reset_after_break();
                 continue;
@@ -452,8 +1347,8 @@ static std::wstring build_beats(const std::wstring& sentence){
         }
 
         // ---- Standalone dash ( -, –, — ) => hard boundary ----
-        if (v[i]==L"-" || v[i]==L"\u2013" || v[i]==L"\u2014"){
-            if(!ends_with_br(out)) out += L" \\!br";
+        if (v[i].len==1 && is_dash(tx(S,v[i])[0])){
+            if(!out.ends_with_br()) out.br();
             reset_after_break();
             ++i;
             continue;
@@ -461,18 +1356,16 @@ static std::wstring build_beats(const std::wstring& sentence){
 
         // ---- Symmetric linker isolation: [BR] linker [BR] ----
         {
-            std::wstring tok = v[i];
-            std::wstring tl  = lower(bare(tok));
+            const Tok& tok = v[i];
             bool in_head_span = (i < 2);
-            if (!in_head_span && (tl==L"at" || tl==L"in" || tl==L"on" || tl==L"to"
-                               || tl==L"of" || tl==L"for"|| tl==L"from"|| tl==L"by")){
-                if(!ends_with_br(out)) out += L" \\!br";        // BEFORE linker
+            if (linkers && !in_head_span && (tok.cls & WC_LINKER)){
+                if(!out.ends_with_br()) out.br();        // BEFORE linker
                 reset_after_break();
 
-                if(!out.empty() && !starts_with_punct(tok) && !is_open_punct(tok)) out.push_back(L' ');
-                out += tok;
+                if(!out.empty() && !starts_with_punct(S,tok) && !is_open_punct(S,tok)) out.sp();
+                out.add(tok);
 
-                if(!ends_with_br(out)) out += L" \\!br";        // AFTER linker
+                if(!out.ends_with_br()) out.br();        // AFTER linker
                 reset_after_break();
 
                 ++i;
@@ -482,44 +1375,28 @@ static std::wstring build_beats(const std::wstring& sentence){
 
 // ---- Pre-copula break: put a beat BEFORE "is" when followed by determiner/contenty ----
 {
-    std::wstring tl_is  = to_lower(bare(v[i]));
     bool in_head_span   = (i < 2);
-    auto is_tag_local   = [&](const std::wstring& w){ return (w==L"\\!br" || w==L"\\!wH1" || w==L"\\!wH0"); };
-
-    auto is_single_letter = [&](const std::wstring& w)->bool{
-        std::wstring b = strip_trailing_punct(w);
-        if (b.size()==1 && iswalpha(b[0]) && iswupper(b[0])) return true;            // C
-        if (b.size()==2 && iswalpha(b[0]) && iswupper(b[0]) && b[1]==L':') return true; // C:
-        return false;
-    };
 
-    auto is_determiner = [&](const std::wstring& w)->bool{
-        std::wstring b = to_lower(strip_trailing_punct(w));
-        return (b==L"the"||b==L"thee"||b==L"a"||b==L"an"||
-                b==L"this"||b==L"that"||b==L"these"||b==L"those"||
-                b==L"some"||b==L"any"||b==L"each"||b==L"every"||b==L"no");
-    };
-
-    if (!in_head_span && tl_is == L"is") {
+    if (copula && !in_head_span && (v[i].cls & WC_IS)) {
         // peek next non-tag token
         size_t k = i + 1;
-        while (k < v.size() && is_tag_local(v[k])) ++k;
+        while (k < v.size() && v[k].kind==TK_TAG) ++k;
 
         bool trigger = false;
         if (k < v.size()) {
-            const std::wstring& n1 = v[k];
-            if (is_determiner(n1) ||
-                is_titlecase_word(strip_trailing_punct(n1)) ||
-                is_all_digits(strip_trailing_punct(n1)) ||
-                is_single_letter(n1) ||
-                weight(n1) == HEAVY)
+            Tok& n1 = v[k];
+            if ((n1.cls & WC_DETERMINER) ||
+                core_titlecase(S,n1) ||
+                core_digits(S,n1) ||
+                core_single_letter(S,n1) ||
+                weight(S,n1) == HEAVY)
             {
                 trigger = true;
             }
         }
 
-        if (trigger && !ends_with_br(out)) {
-            out += L" \\!br";
+        if (trigger && !out.ends_with_br()) {
+            out.br();
             // reset run state like a real boundary
             since_break_all_light = true;
             content_run = 0;
@@ -532,60 +1409,60 @@ static std::wstring build_beats(const std::wstring& sentence){
         if (emit_dash_split(v[i])) { ++i; continue; }
 
         // ---- Generic token logic ----
-        std::wstring tok = v[i];
-        Wt w_eff = weight(tok); // effective weight; may be softened at sentence start
+        Tok& tok = v[i];
+        Wt w_eff = weight(S,tok); // effective weight; may be softened at sentence start
 
         // Soft-start: first two tokens—avoid pre-breaks unless necessary.
         bool in_head_span = (i < 2);
-        if (i==0 && is_titlecase_word(bare(tok))) {
-            bool next_is_title = (i+1 < v.size()) && is_titlecase_word(bare(v[i+1]));
+        if (i==0 && core_titlecase(S,tok)) {
+            bool next_is_title = (i+1 < v.size()) && core_titlecase(S,v[i+1]);
             if (!next_is_title && w_eff == HEAVY) w_eff = MEDIUM; // e.g., "Good evening"
         }
 
         // ---- HEAVY-GATE ----
         if (w_eff==HEAVY && content_run >= 1){
             int k = static_cast<int>(i) - 1;
-            while (k >= 0 && is_tag(v[k])) --k;
+            while (k >= 0 && v[k].kind==TK_TAG) --k;
             bool exempt = false;
             if (k >= 0){
-                std::wstring prev = v[k];
-                if (is_titlecase_word(bare(prev)) || is_all_digits(bare(prev)) || is_single_letter(prev)) {
+                const Tok& prev = v[k];
+                if (core_titlecase(S,prev) || core_digits(S,prev) || core_single_letter(S,prev)) {
                     exempt = true;
                 }
             }
             if (!exempt){
-                if(!ends_with_br(out)) out += L" \\!br";
+                if(!out.ends_with_br()) out.br();
                 reset_after_break();
             }
         }
 
-        // 3-beat limiter
-        if (w_eff==HEAVY && content_run >= 2){
-            if(!ends_with_br(out)) out += L" \\!br";
+        // 3-beat limiter (VoxRules::max_beats)
+        if (w_eff==HEAVY && content_run >= max_beats-1){
+            if(!out.ends_with_br()) out.br();
             reset_after_break();
         }
 
         // Heavy after only LIGHT (but not inside head span)
         if (w_eff==HEAVY && since_break_all_light && !in_head_span){
-            if(!out.empty() && !ends_with_br(out)) out += L" \\!br";
+            if(!out.empty() && !out.ends_with_br()) out.br();
             reset_after_break();
         }
 
         // Heavy-Heavy adjacency (outside TitleCase run)
         if (i>0 && prev_w==HEAVY && w_eff==HEAVY && !in_head_span){
-            if(!ends_with_br(out)) out += L" \\!br";
+            if(!out.ends_with_br()) out.br();
             reset_after_break();
         }
 
         // Append token with spacing
-        if(!out.empty() && !starts_with_punct(tok) && !is_open_punct(tok)) out.push_back(L' ');
-        out += tok;
+        if(!out.empty() && !starts_with_punct(S,tok) && !is_open_punct(S,tok)) out.sp();
+        out.add(tok);
 
         // Punctuation boundary: break after ',' or ';'
-        if (!tok.empty()){
-            wchar_t last = tok.back();
-            if ((last==L',' || last==L';') && !ends_with_br(out)){
-                out += L" \\!br";
+        {
+            wchar_t last = tx(S,tok)[tok.len-1];
+            if ((last==L',' || last==L';') && !out.ends_with_br()){
+                out.br();
                 reset_after_break();
                 ++i;
                 continue;
@@ -604,23 +1481,7 @@ static std::wstring build_beats(const std::wstring& sentence){
         ++i;
     }
 
-    return trim(out);
-}
-
-
-
-
-// Tidy spaces and tags
-static std::wstring tidy(const std::wstring& s){
-    std::wstring t = std::regex_replace(s, std::wregex(LR"(\s+)"), L" ");            // collapse spaces
-    t = std::regex_replace(t, std::wregex(LR"(\s*\\!br\s*)"), L" \\!br ");           // normalize tag spacing
-    t = std::regex_replace(t, std::wregex(LR"((\s*\\!br\s*){2,})"), L" \\!br ");     // collapse multiple breaks
-    t = std::regex_replace(t, std::wregex(LR"(\s+([.,!?;:]))"), L"$1");              // no space before punctuation
-    // trimyou 
-    size_t a=0,b=t.size();
-    while(a<b && iswspace(t[a])) ++a;
-    while(b>a && iswspace(t[b-1])) --b;
-    return t.substr(a,b-a);
+    S.toks.swap(S.spare);
 }
 
 
@@ -628,117 +1489,349 @@ static std::wstring tidy(const std::wstring& s){
 // - "A:" / "a:" / bare "A"/"a" near a boundary -> "Ay:"
 // - any single UPPERCASE letter near a boundary -> "X:" (exactly one colon)
 // Boundaries are start/end or a \!br tag on either side. We preserve trailing punctuation.
-static void normalize_letter_tokens(std::wstring& s){
-    // split by whitespace; keep tags as tokens
-    std::wstringstream ss(s);
-    std::vector<std::wstring> tok; std::wstring t;
-    while (ss >> t) tok.push_back(t);
-    if (tok.empty()) return;
-
-    auto is_tag = [](const std::wstring& w){
-        return (w==L"\\!br" || w==L"\\!wH1" || w==L"\\!wH0");
-    };
-
-    // strip trailing punctuation, but lift out a single trailing ':' as a flag
-    auto split_tail = [](const std::wstring& x)->std::tuple<std::wstring,bool,std::wstring>{
-        std::wstring core = x, punct;
-        bool had_colon = false;
-        // peel general punctuation, but remember a single trailing ':'
-        while(!core.empty()){
-            wchar_t c = core.back();
-            if(c==L':' && !had_colon){ had_colon = true; core.pop_back(); continue; }
-            if(c==L','||c==L'.'||c==L';'||c==L'!'||c==L'?'||c==L'"'||c==L'\''){
-                punct.insert(punct.begin(), c);
-                core.pop_back();
-                continue;
-            }
-            break;
-        }
-        return {core, had_colon, punct};
-    };
-
+static void normalize_letter_tokens(Sentence& S){
+    auto& tok = S.toks;
     auto is_boundary = [&](int idx)->bool{
-        return (idx < 0 || idx >= (int)tok.size() || is_tag(tok[idx]));
+        return (idx < 0 || idx >= (int)tok.size() || tok[idx].kind==TK_TAG);
     };
 
     for (int i=0;i<(int)tok.size();++i){
-        if (is_tag(tok[i])) continue;
+        if (tok[i].kind==TK_TAG) continue;
+        const Tok t = tok[i];
 
-        auto [coreOrig, had_colon, tail] = split_tail(tok[i]);
-        std::wstring core = coreOrig;
+        // strip trailing punctuation, but lift out a single trailing ':' as a flag
+        size_t core = t.len, colon_at = t.len;
+        bool had_colon = false;
+        {
+            const wchar_t* p = tx(S,t);
+            while(core>0){
+                wchar_t c = p[core-1];
+                if(c==L':' && !had_colon){ had_colon = true; colon_at = --core; continue; }
+                if(c==L','||c==L'.'||c==L';'||c==L'!'||c==L'?'||c==L'"'||c==L'\''){ --core; continue; }
+                break;
+            }
+        }
 
         const bool near_left  = is_boundary(i-1);
         const bool near_right = is_boundary(i+1);
         const bool near_bound = (near_left || near_right);
+        const wchar_t c0 = S.buf[t.off];
 
+        // Rebuild at the end of the buffer; dropped again when nothing changed
+        const size_t off = S.buf.size();
         // Normalize A / a cases to "Ay:" when isolated or already written as A:
-        if ((core==L"A" || core==L"a") && (near_bound || had_colon)){
-            core = L"Ay";
+        if (core==1 && (c0==L'A' || c0==L'a') && (near_bound || had_colon)){
+            S.buf += L"Ay";
             had_colon = true; // ensure exactly one colon added below
-        }
-        // Any other single UPPERCASE letter becomes a letter token near a boundary
-        else if (core.size()==1 && iswalpha(core[0]) && iswupper(core[0]) && near_bound){
-            // ensure exactly one colon
-            // (if there was already one as trailing punct, we won't add another)
-            // special "A" handled above
-            had_colon = true;
+        } else {
+            S.buf.append(S.buf, t.off, core);
+            // Any other single UPPERCASE letter becomes a letter token near a boundary
+            if (core==1 && iswalpha(c0) && iswupper(c0) && near_bound) had_colon = true;
         }
 
         // Reassemble: add colon iff had_colon is true, then the rest of punctuation
-        std::wstring rebuilt = core;
-        if (had_colon) rebuilt.push_back(L':');
-        rebuilt += tail;
+        if (had_colon) S.buf.push_back(L':');
+        for (size_t c=core;c<t.len;++c) if (c!=colon_at) S.buf.push_back(S.buf[t.off+c]);
 
-        tok[i] = rebuilt;
+        const size_t n = S.buf.size()-off;
+        if (n==t.len && S.buf.compare(off, n, S.buf, t.off, t.len)==0) S.buf.resize(off);
+        else tok[i] = make_tok(S, off, n);
     }
+}
+
 
-    // Rebuild s (tidy() will normalize spaces/tags later)
-    std::wstring out;
-    for (size_t i=0;i<tok.size();++i){
-        if (!out.empty()) out.push_back(L' ');
-        out += tok[i];
+// ---- Serialization + tidy ----
+static inline size_t skip_ws(const std::wstring& s, size_t i){
+    while(i<s.size() && iswspace(s[i])) ++i;
+    return i;
+}
+static inline bool has_br_at(const std::wstring& s, size_t i){
+    return s.compare(i, 4, L"\\!br") == 0;
+}
+
+// Rewrites every run of `ws* \!br ws*` units of `s` into `out`. Runs of at least `min_units`
+// become a single " \!br " (min_units==1 normalizes each tag's spacing); shorter runs are
+// copied unchanged.
+static void collapse_br_runs(const std::wstring& s, size_t min_units, std::wstring& out){
+    out.clear();
+    size_t i = 0;
+    while(i < s.size()){
+        size_t p = skip_ws(s, i);
+        if(!has_br_at(s, p)){
+            if(p==i) out.push_back(s[i++]);
+            else { out.append(s, i, p-i); i = p; }
+            continue;
+        }
+        size_t units = 0, e = p;
+        while(has_br_at(s, e)){ ++units; e = skip_ws(s, e+4); }
+        if(units >= min_units){
+            if(min_units > 1) out += L" \\!br ";
+            else for(size_t k=0;k<units;++k) out += L" \\!br ";
+        } else {
+            out.append(s, i, e-i);
+        }
+        i = e;
     }
-    s.swap(out);
 }
 
+// Per-thread scratch reused across calls, so a vox_process() call in steady state only
+// allocates its result. Buffers that grew past kScratchKeep chars for one huge message are
+// released afterwards instead of being pinned for the life of the thread.
+struct VoxScratch {
+    Sentence          S;
+    std::vector<Span> sents;
+    std::wstring      acc, t1, t2;
+};
+static constexpr size_t kScratchKeep = 64 * 1024;
+
+static VoxScratch& vox_scratch(){
+    static thread_local VoxScratch sc;
+    return sc;
+}
+static void vox_scratch_release(VoxScratch& sc){
+    auto drop = [](std::wstring& s){ if(s.capacity() > kScratchKeep) std::wstring().swap(s); };
+    drop(sc.S.buf); drop(sc.acc); drop(sc.t1); drop(sc.t2);
+    if(sc.S.toks.capacity() > kScratchKeep/8){
+        std::vector<Tok>().swap(sc.S.toks);
+        std::vector<Tok>().swap(sc.S.spare);
+    }
+}
 
-std::wstring vox_process(const std::wstring& in, bool wrap_vox_tags){
-    auto sents = split_sentences(in);
-    std::wstring out;
-    for (auto sent : sents){
-        if (sent.empty()) continue;
+// Tidy spaces and tags; this is where the token array becomes text again (appended to `out`)
+static void tidy(const Sentence& S, VoxScratch& sc, std::wstring& out){
+    std::wstring& t = sc.t1;
+    t.clear();
+    for(const Tok& k : S.toks){
+        if(!t.empty()) t.push_back(L' ');
+        t.append(S.buf, k.off, k.len);
+    }
+    collapse_br_runs(t, 1, sc.t2);   // normalize tag spacing
+    collapse_br_runs(sc.t2, 2, t);   // collapse multiple breaks
+    // no space before punctuation
+    std::wstring& u = sc.t2;
+    u.clear();
+    for(size_t i=0;i<t.size();){
+        if(iswspace(t[i])){
+            size_t p = skip_ws(t, i);
+            wchar_t c = (p<t.size()) ? t[p] : 0;
+            if(c==L'.'||c==L','||c==L'!'||c==L'?'||c==L';'||c==L':'){ u.push_back(t[p]); i = p+1; }
+            else { u.append(t, i, p-i); i = p; }
+        } else u.push_back(t[i++]);
+    }
+    Span r = trim_span(u, 0, u.size());
+    out.append(u, r.a, r.b-r.a);
+}
 
-        // ORDER: make "thee" first, then lead-in, then time/nums
-        apply_thee_rule(sent);
-        apply_leadin_break(sent);
-        apply_time_numbers_degrees(sent);
 
-        // beats + letter normalization
-        std::wstring with_beats = build_beats(sent);
-        normalize_letter_tokens(with_beats);
-        with_beats = tidy(with_beats);
+// Stage sizes for the counters; constant 0 when they are compiled out.
+static inline size_t tok_units(const Sentence& S){
+#if NETTTS_VOX_STATS
+    size_t n = S.toks.empty() ? 0 : S.toks.size()-1;
+    for(const Tok& t : S.toks) n += t.len;
+    return n;
+#else
+    (void)S; return 0;
+#endif
+}
+static inline size_t span_units(const std::vector<Span>& v){
+#if NETTTS_VOX_STATS
+    size_t n = 0;
+    for(const Span& sp : v) n += sp.b - sp.a;
+    return n;
+#else
+    (void)v; return 0;
+#endif
+}
 
-        // sentence-end cadence: add ~300ms pause, then a boundary
-        if (!with_beats.empty() && with_beats.back()!=L' ') with_beats.push_back(L' ');
-        with_beats += L"\\!sf500 \\!br";
+static void append_uint(std::wstring& out, unsigned v){
+    wchar_t d[10]; int n = 0;
+    do { d[n++] = (wchar_t)(L'0' + v%10); v /= 10; } while(v);
+    while(n) out.push_back(d[--n]);
+}
 
-        if (!out.empty()) out.push_back(L' ');
-        out += with_beats;
-    }
+// One sentence through every rule; appends its text plus the end-of-sentence cadence to `out`.
+static void encode_sentence(const std::wstring& in, Span sent, const VoxRules& R, VoxScratch& sc, std::wstring& out){
+    Sentence& S = sc.S;
+    S.R = &R;
+    stage_begin(VOX_STAGE_TOKENIZE, sent.b-sent.a); tokenize(S, in, sent); stage_end(VOX_STAGE_TOKENIZE, tok_units(S));
+
+    // ORDER: make "thee" first, then lead-in, then time/nums
+    stage_begin(VOX_STAGE_THEE, tok_units(S));
+    if(R.flags & VR_THEE) apply_thee_rule(S);
+    stage_end(VOX_STAGE_THEE, tok_units(S));
+    stage_begin(VOX_STAGE_LEADIN, tok_units(S));
+    if(R.flags & VR_LEADIN) apply_leadin_break(S);
+    stage_end(VOX_STAGE_LEADIN, tok_units(S));
+    stage_begin(VOX_STAGE_NUMBERS, tok_units(S));
+    if(R.flags & VR_NUMBERS) apply_time_numbers_degrees(S);
+    stage_end(VOX_STAGE_NUMBERS, tok_units(S));
+
+    // beats + letter normalization
+    stage_begin(VOX_STAGE_BEATS, tok_units(S));   build_beats(S);             stage_end(VOX_STAGE_BEATS, tok_units(S));
+    stage_begin(VOX_STAGE_LETTERS, tok_units(S)); normalize_letter_tokens(S); stage_end(VOX_STAGE_LETTERS, tok_units(S));
+
+    if (!out.empty()) out.push_back(L' ');
+    size_t mark = out.size();
+    stage_begin(VOX_STAGE_TIDY, tok_units(S));    tidy(S, sc, out);           stage_end(VOX_STAGE_TIDY, out.size()-mark);
+
+    // sentence-end cadence: pause (VoxRules::pause_cs), then a boundary
+    if (out.size()>mark) out.push_back(L' ');
+    out += L"\\!sf";
+    append_uint(out, R.pause_cs);
+    out += L" \\!br";
+}
 
-    out = trim(out);
+// Joined sentences -> one chunk ready for tts_speak (consumes `out`).
+static std::wstring finish_chunk(VoxScratch& sc, std::wstring& out, bool wrap_vox_tags){
     // collapse accidental double breaks from joins, normalize commas before breaks, etc.
-    out = std::regex_replace(out, std::wregex(LR"((\s*\\!br\s*){2,})"), L" \\!br ");
-    out = std::regex_replace(out, std::wregex(LR"(\\!br\s*([,;:]))"), L"$1 \\!br");
-
-    if (!out.empty()) {
-        if (wrap_vox_tags) {
-            out = L"\\!wH1 " + out + L" \\!wH0 ";
-        } else {
-            out = out + L" ";
+    Span r = trim_span(out, 0, out.size());
+    out.erase(r.b); out.erase(0, r.a);
+    collapse_br_runs(out, 2, sc.t1);
+    const std::wstring& c = sc.t1;
+    std::wstring& t = sc.t2;
+    t.clear();
+    for(size_t i=0;i<c.size();){
+        if(has_br_at(c, i)){
+            size_t p = skip_ws(c, i+4);
+            if(p<c.size() && (c[p]==L',' || c[p]==L';' || c[p]==L':')){
+                t.push_back(c[p]);
+                t += L" \\!br";
+                i = p+1;
+                continue;
+            }
         }
+        t.push_back(c[i++]);
     }
-    return out;
+
+    std::wstring res;
+    if (!t.empty()) {
+        res.reserve(t.size() + 16);
+        if (wrap_vox_tags) res += L"\\!wH1 ";
+        res += t;
+        res += wrap_vox_tags ? L" \\!wH0 " : L" ";
+    }
+    return res;
+}
+
+std::wstring vox_process(const std::wstring& in, bool wrap_vox_tags, const VoxRules* rules){
+    const VoxRules& R = rules ? *rules : kBuiltinRules;
+    VoxScratch& sc = vox_scratch();
+    std::wstring& out = sc.acc;
+    out.clear();
+
+    stage_begin(VOX_STAGE_SPLIT, in.size());
+    split_sentences(in, sc.sents);
+    stage_end(VOX_STAGE_SPLIT, span_units(sc.sents));
+    for (const Span& sent : sc.sents){
+        if (sent.b==sent.a) continue;
+        encode_sentence(in, sent, R, sc, out);
+    }
+
+    stage_begin(VOX_STAGE_FINISH, out.size());
+    std::wstring res = finish_chunk(sc, out, wrap_vox_tags);
+    stage_end(VOX_STAGE_FINISH, res.size());
+    vox_scratch_release(sc);
+    return res;
+}
+
+void vox_split_sentences(const std::wstring& in, std::vector<VoxSpan>& spans){
+    stage_begin(VOX_STAGE_SPLIT, in.size());
+    split_sentences(in, spans);
+    stage_end(VOX_STAGE_SPLIT, span_units(spans));
+}
+
+void vox_encode_sentence(const std::wstring& in, VoxSpan sent, std::wstring& out, const VoxRules* rules){
+    if (sent.b==sent.a) return;
+    VoxScratch& sc = vox_scratch();
+    encode_sentence(in, sent, rules ? *rules : kBuiltinRules, sc, out);
+    vox_scratch_release(sc);
+}
+
+std::wstring vox_finish_text(std::wstring& joined, bool wrap_vox_tags){
+    VoxScratch& sc = vox_scratch();
+    stage_begin(VOX_STAGE_FINISH, joined.size());
+    std::wstring res = finish_chunk(sc, joined, wrap_vox_tags);
+    stage_end(VOX_STAGE_FINISH, res.size());
+    vox_scratch_release(sc);
+    return res;
+}
+
+void vox_encode_fragment(const std::wstring& in, std::wstring& out, const VoxRules* rules){
+    Span r = trim_span(in, 0, in.size());
+    if (r.b==r.a) return;
+    const VoxRules& R = rules ? *rules : kBuiltinRules;
+    VoxScratch& sc = vox_scratch();
+    Sentence& S = sc.S;
+    S.R = &R;
+    tokenize(S, in, r);
+    stage_begin(VOX_STAGE_NUMBERS, tok_units(S));
+    if(R.flags & VR_NUMBERS) apply_time_numbers_degrees(S);
+    stage_end(VOX_STAGE_NUMBERS, tok_units(S));
+    stage_begin(VOX_STAGE_LETTERS, tok_units(S)); normalize_letter_tokens(S); stage_end(VOX_STAGE_LETTERS, tok_units(S));
+    tidy(S, sc, out);
+    vox_scratch_release(sc);
+}
+
+// ---- Streaming ----
+void vox_stream_init(VoxStream& vs, bool wrap_vox_tags, const VoxRules* rules){
+    vs.pending.clear();
+    vs.rules     = rules;
+    vs.scan      = 0;
+    vs.wrap      = wrap_vox_tags;
+    vs.closed    = false;
+    vs.continued = false;
+}
+
+void vox_stream_feed(VoxStream& vs, const std::wstring& text){
+    vs.pending += text;
 }
 
+void vox_stream_finish(VoxStream& vs){
+    vs.closed = true;
+}
+
+bool vox_stream_next(VoxStream& vs, std::wstring& chunk){
+    const std::wstring& in = vs.pending;
+    for(;;){
+        // find the end of the next sentence (same rule as split_sentences)
+        size_t end = std::wstring::npos;
+        for(size_t i=vs.scan;i<in.size();++i){
+            wchar_t c = in[i];
+            if((c==L'.' && !is_decimal_point(in, i)) || c==L'!' || c==L'?'){
+                size_t j=i+1;
+                while(j<in.size() && (in[j]==L'"' || in[j]==L'\'')) ++j;
+                if(j==in.size() && !vs.closed){ vs.scan = i; return false; } // closing quotes may follow
+                end = j;
+                break;
+            }
+        }
+        if(end==std::wstring::npos){
+            vs.scan = in.size();
+            if(!vs.closed || in.empty()) return false;
+            end = in.size();
+        }
 
+        Span sent = trim_span(in, 0, end);
+        if(sent.b==sent.a){ vs.pending.erase(0, end); vs.scan = 0; continue; }
+
+        VoxScratch& sc = vox_scratch();
+        std::wstring& out = sc.acc;
+        out.clear();
+        encode_sentence(in, sent, vs.rules ? *vs.rules : kBuiltinRules, sc, out);
+        vs.pending.erase(0, end);
+        vs.scan = 0;
+
+        // the previous chunk already ended on a boundary; don't open this one with another
+        if(vs.continued){
+            size_t p = skip_ws(out, 0);
+            while(has_br_at(out, p)) p = skip_ws(out, p+4);
+            out.erase(0, p);
+        }
+        stage_begin(VOX_STAGE_FINISH, out.size());
+        chunk = finish_chunk(sc, out, vs.wrap);
+        stage_end(VOX_STAGE_FINISH, chunk.size());
+        vox_scratch_release(sc);
+        vs.continued = true;
+        return true;
+    }
+}
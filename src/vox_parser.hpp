@@ -1,8 +1,50 @@
 #pragma once
 #include <string>
+#include <vector>
+
+struct VoxRules;   // vox_rules.hpp; nullptr below = the built-in rules
 
 // Transform plain text into FlexTalk VOX style with vendor tags.
 // - Wraps with \!wH1 ... \!wH0 (trailing space after \!wH0 for safety)
 // - Inserts \!br at sentence ends & cadence points
 // - Uses a generic prosody engine (no word-specific hacks)
-std::wstring vox_process(const std::wstring& in, bool wrap_vox_tags);
+std::wstring vox_process(const std::wstring& in, bool wrap_vox_tags, const VoxRules* rules = nullptr);
+
+// Sentence-level pieces of vox_process(), for callers that spread one text over threads
+// (--vox-batch). vox_process(in, wrap) is exactly: split, vox_encode_sentence() each span,
+// join the non-empty results with one space, then vox_finish_text(). Each call only uses the
+// calling thread's scratch buffers, so sentences of one text can be encoded on any thread.
+struct VoxSpan { size_t a, b; };   // [a,b) of the input, already trimmed
+void vox_split_sentences(const std::wstring& in, std::vector<VoxSpan>& spans);
+// Appends the encoded sentence to `out` (space-separated when `out` is not empty).
+void vox_encode_sentence(const std::wstring& in, VoxSpan sent, std::wstring& out,
+                         const VoxRules* rules = nullptr);
+// Joined sentences -> final text (consumes `joined`).
+std::wstring vox_finish_text(std::wstring& joined, bool wrap_vox_tags);
+
+// Word-level rules only (numbers, times, letter tokens) for a fragment that is spliced into
+// already-encoded text, e.g. a template slot value: no beats, breaks or cadence. Appends to `out`.
+void vox_encode_fragment(const std::wstring& in, std::wstring& out, const VoxRules* rules = nullptr);
+
+// The encoder's syllable heuristic for one word (at least 1), e.g. for duration estimates.
+int vox_syllables(const wchar_t* w, size_t n);
+
+// Incremental VOX encoder: text can arrive in pieces and each sentence comes out as its
+// own chunk as soon as its terminator (plus any closing quotes) has been seen, so the
+// first sentence can be speaking while later ones are still being fed or encoded.
+// Every chunk is self-contained (wrapped on its own when wrap_vox_tags is set), so the
+// queue can stop between chunks without leaving the engine in \!wH1 mode.
+struct VoxStream {
+    std::wstring    pending;             // text not yet emitted
+    size_t          scan      = 0;       // resume point when looking for the next terminator
+    const VoxRules* rules     = nullptr;
+    bool            wrap      = true;
+    bool            closed    = false;   // vox_stream_finish() called: the tail is a sentence too
+    bool            continued = false;   // a chunk was already emitted
+};
+
+void vox_stream_init(VoxStream& vs, bool wrap_vox_tags, const VoxRules* rules = nullptr);
+void vox_stream_feed(VoxStream& vs, const std::wstring& text);
+void vox_stream_finish(VoxStream& vs);
+// Encodes the next finished sentence into `chunk`; false when none is ready yet.
+bool vox_stream_next(VoxStream& vs, std::wstring& chunk);
@@ -0,0 +1,407 @@
+#include "vox_rulepack.hpp"
+#include "util.hpp"
+#include <windows.h>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <cwctype>
+
+namespace {
+
+// ---- NTRP file layout (little-endian; every section 4-byte aligned) ----
+struct NtrpHeader {
+    char     magic[4];          // "NTRP"
+    uint32_t version;
+    uint32_t file_size;
+    uint32_t name_off, name_len;            // UTF-8, NUL-terminated in the file
+    uint16_t pause_cs;
+    uint8_t  max_beats, heavy_syllables, heavy_chars, reserved;
+    uint16_t flags;
+    uint32_t slot_count, slots_off;         // VoxWordSlot[slot_count]
+    uint32_t bucket_count, disp_off;        // uint32_t[bucket_count]
+    uint32_t leadin_count, leadins_off;     // VoxPhrase[leadin_count]
+    uint32_t pool_units, pool_off;          // uint16_t[pool_units]
+};
+static_assert(sizeof(NtrpHeader) == 60, "NTRP header layout");
+static_assert(sizeof(VoxWordSlot) == 12 && sizeof(VoxPhrase) == 8, "NTRP record layout");
+constexpr uint32_t kNtrpVersion = 1;
+
+// ---- compiler ----
+struct PackSource {
+    std::string                name;
+    VoxRules                   policy{};            // only the policy fields are used
+    bool                       has_class[WC_COUNT] = {};
+    std::vector<std::wstring>  words[WC_COUNT];
+    bool                       has_leadins = false;
+    std::vector<std::wstring>  leadins;
+};
+
+std::wstring lower_w(std::wstring w){
+    for (wchar_t& c : w) c = (wchar_t)towlower(c);
+    return w;
+}
+
+void builtin_words(int bit, std::vector<std::wstring>& out){
+    const VoxRules& R = vox_builtin_rules();
+    for (uint32_t i = 0; i < R.slot_count; ++i){
+        const VoxWordSlot& s = R.slots[i];
+        if (s.len && (s.cls & (1u << bit))) out.emplace_back(R.pool + s.off, R.pool + s.off + s.len);
+    }
+}
+
+void builtin_leadins(std::vector<std::wstring>& out){
+    const VoxRules& R = vox_builtin_rules();
+    for (uint32_t i = 0; i < R.leadin_count; ++i)
+        out.emplace_back(R.pool + R.leadins[i].off, R.pool + R.leadins[i].off + R.leadins[i].len);
+}
+
+bool parse_source(const std::string& text, PackSource& ps, std::string& err){
+    ps.policy = vox_builtin_rules();
+    int section = -2;   // -2: header keys, -1: [leadin], else a WordClass bit
+    size_t pos = 0, lineno = 0;
+    auto fail = [&](const char* what){
+        char buf[160]; snprintf(buf, sizeof(buf), "line %u: %s", (unsigned)lineno, what);
+        err = buf; return false;
+    };
+    while (pos < text.size()){
+        size_t nl = text.find('\n', pos);
+        std::string line = text.substr(pos, nl == std::string::npos ? std::string::npos : nl - pos);
+        pos = (nl == std::string::npos) ? text.size() : nl + 1;
+        ++lineno;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        while (!line.empty() && isspace((unsigned char)line.back())) line.pop_back();
+        size_t b = 0; while (b < line.size() && isspace((unsigned char)line[b])) ++b;
+        line.erase(0, b);
+        if (line.empty()) continue;
+
+        if (line[0] == '['){
+            if (line.back() != ']') return fail("unterminated section header");
+            std::string sec = line.substr(1, line.size() - 2);
+            if (sec == "leadin"){ section = -1; ps.has_leadins = true; continue; }
+            section = -3;
+            for (int k = 0; k < WC_COUNT; ++k) if (sec == vox_word_class_name(k)) section = k;
+            if (section == -3) return fail("unknown section");
+            ps.has_class[section] = true;
+            continue;
+        }
+        if (section == -1){   // one phrase per line, words separated by single spaces
+            std::wstring w = lower_w(u8_to_w(line)), phrase;
+            for (size_t i = 0; i < w.size(); ++i){
+                if (iswspace(w[i])){ if (!phrase.empty() && phrase.back() != L' ') phrase.push_back(L' '); }
+                else phrase.push_back(w[i]);
+            }
+            ps.leadins.push_back(phrase);
+            continue;
+        }
+        if (section >= 0){    // whitespace-separated words
+            std::wstring w = lower_w(u8_to_w(line));
+            size_t i = 0;
+            while (i < w.size()){
+                while (i < w.size() && iswspace(w[i])) ++i;
+                size_t s = i;
+                while (i < w.size() && !iswspace(w[i])) ++i;
+                if (i > s) ps.words[section].push_back(w.substr(s, i - s));
+            }
+            continue;
+        }
+        // key = value
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) return fail("expected key = value");
+        std::string key = line.substr(0, eq), val = line.substr(eq + 1);
+        while (!key.empty() && isspace((unsigned char)key.back())) key.pop_back();
+        while (!val.empty() && isspace((unsigned char)val[0])) val.erase(0, 1);
+        int n = atoi(val.c_str());
+        if      (key == "name")            ps.name = val;
+        else if (key == "pause")           { if (n < 0 || n > 9999) return fail("pause must be 0..9999"); ps.policy.pause_cs = (uint16_t)n; }
+        else if (key == "max_beats")       { if (n < 2 || n > 16) return fail("max_beats must be 2..16"); ps.policy.max_beats = (uint8_t)n; }
+        else if (key == "heavy_syllables") { if (n < 1 || n > 16) return fail("heavy_syllables must be 1..16"); ps.policy.heavy_syllables = (uint8_t)n; }
+        else if (key == "heavy_chars")     { if (n < 1 || n > 64) return fail("heavy_chars must be 1..64"); ps.policy.heavy_chars = (uint8_t)n; }
+        else if (key == "rules"){
+            static const struct { const char* name; uint16_t flag; } kRules[] = {
+                {"thee", VR_THEE}, {"leadin", VR_LEADIN}, {"numbers", VR_NUMBERS},
+                {"linkers", VR_LINKERS}, {"copula", VR_COPULA}
+            };
+            uint16_t flags = 0;
+            size_t i = 0;
+            while (i < val.size()){
+                while (i < val.size() && (isspace((unsigned char)val[i]) || val[i] == ',')) ++i;
+                size_t s = i;
+                while (i < val.size() && !isspace((unsigned char)val[i]) && val[i] != ',') ++i;
+                if (i == s) break;
+                std::string r = val.substr(s, i - s);
+                bool known = false;
+                for (const auto& k : kRules) if (r == k.name){ flags |= k.flag; known = true; }
+                if (r == "none") known = true;
+                if (!known) return fail("unknown rule (thee leadin numbers linkers copula none)");
+            }
+            ps.policy.flags = flags;
+        }
+        else return fail("unknown key");
+    }
+    if (ps.name.empty() || ps.name.size() > 64) { err = "pack needs a name (1..64 chars)"; return false; }
+    for (char c : ps.name) if (isspace((unsigned char)c)) { err = "pack name cannot contain spaces"; return false; }
+    for (int k = 0; k < WC_COUNT; ++k) if (!ps.has_class[k]) builtin_words(k, ps.words[k]);
+    if (!ps.has_leadins) builtin_leadins(ps.leadins);
+    return true;
+}
+
+template<class T> uint32_t append_pod(std::string& blob, const T* p, size_t n){
+    while (blob.size() % 4) blob.push_back('\0');
+    uint32_t off = (uint32_t)blob.size();
+    blob.append((const char*)p, n * sizeof(T));
+    return off;
+}
+
+bool build_blob(const PackSource& ps, std::string& blob, std::string& err){
+    // merge classes: one entry per distinct word
+    std::vector<std::wstring> word;
+    std::vector<uint16_t>     cls;
+    std::unordered_map<std::wstring, uint32_t> index;   // word -> its entry
+    for (int k = 0; k < WC_COUNT; ++k){
+        for (const std::wstring& w : ps.words[k]){
+            if (w.empty() || w.size() > 0xFFFF) continue;
+            auto r = index.emplace(w, (uint32_t)word.size());
+            if (r.second){ word.push_back(w); cls.push_back(0); }
+            const uint32_t i = r.first->second;
+            cls[i] = (uint16_t)(cls[i] | (1u << k));
+        }
+    }
+    const uint32_t n = (uint32_t)word.size();
+    std::vector<uint32_t> hash(n);
+    for (uint32_t k = 0; k < n; ++k){
+        uint32_t h = kVoxFnvBasis;
+        for (wchar_t c : word[k]){ h ^= (uint32_t)(uint16_t)c; h *= kVoxFnvPrime; }
+        hash[k] = h;
+    }
+    const uint32_t slots = vox_slots_for(n), buckets = vox_buckets_for(n);
+    std::vector<uint32_t> disp(buckets, 0), slot_of(n, 0);
+    std::vector<bool> used(slots, false);
+    std::vector<uint32_t> order(n);
+    if (!vox_place_words(hash, n, disp, buckets, slot_of, used, slots, order)){
+        err = "no perfect hash for these word lists";
+        return false;
+    }
+
+    std::vector<uint16_t>    pool;
+    std::vector<VoxWordSlot> slot(slots, VoxWordSlot{0, 0, 0, 0});
+    for (uint32_t k = 0; k < n; ++k){
+        slot[slot_of[k]] = VoxWordSlot{ (uint32_t)pool.size(), (uint16_t)word[k].size(), cls[k], hash[k] };
+        for (wchar_t c : word[k]) pool.push_back((uint16_t)c);
+    }
+    std::vector<VoxPhrase> leadin;
+    for (const std::wstring& p : ps.leadins){
+        if (p.empty()) continue;
+        leadin.push_back(VoxPhrase{ (uint32_t)pool.size(), (uint32_t)p.size() });
+        for (wchar_t c : p) pool.push_back((uint16_t)c);
+    }
+
+    NtrpHeader h{};
+    blob.assign(sizeof(h), '\0');
+    h.name_off     = (uint32_t)blob.size();
+    h.name_len     = (uint32_t)ps.name.size();
+    blob.append(ps.name); blob.push_back('\0');
+    h.slot_count   = slots;   h.slots_off   = append_pod(blob, slot.data(), slot.size());
+    h.bucket_count = buckets; h.disp_off    = append_pod(blob, disp.data(), disp.size());
+    h.leadin_count = (uint32_t)leadin.size();
+    h.leadins_off  = append_pod(blob, leadin.data(), leadin.size());
+    h.pool_units   = (uint32_t)pool.size();
+    h.pool_off     = append_pod(blob, pool.data(), pool.size());
+    memcpy(h.magic, "NTRP", 4);
+    h.version         = kNtrpVersion;
+    h.file_size       = (uint32_t)blob.size();
+    h.pause_cs        = ps.policy.pause_cs;
+    h.max_beats       = ps.policy.max_beats;
+    h.heavy_syllables = ps.policy.heavy_syllables;
+    h.heavy_chars     = ps.policy.heavy_chars;
+    h.flags           = ps.policy.flags;
+    memcpy(&blob[0], &h, sizeof(h));
+    return true;
+}
+
+// ---- loader ----
+bool section_ok(const NtrpHeader& h, uint32_t off, uint32_t count, size_t elem){
+    return off % 4 == 0 && off >= sizeof(NtrpHeader) && off <= h.file_size &&
+           (uint64_t)count * elem <= h.file_size - off;
+}
+
+// Checks a mapped pack and points `R` into it; nothing is copied.
+bool view_pack(const void* base, size_t size, VoxRules& R, std::string& err){
+    const char* p = (const char*)base;
+    if (size < sizeof(NtrpHeader)){ err = "file too small"; return false; }
+    NtrpHeader h; memcpy(&h, p, sizeof(h));
+    if (memcmp(h.magic, "NTRP", 4) != 0){ err = "not a compiled rule pack"; return false; }
+    if (h.version != kNtrpVersion){ err = "unsupported rule pack version"; return false; }
+    if (h.file_size != size){ err = "truncated rule pack"; return false; }
+    auto pow2 = [](uint32_t v){ return v && !(v & (v-1)); };
+    if (!pow2(h.slot_count) || !pow2(h.bucket_count) ||
+        !section_ok(h, h.slots_off,   h.slot_count,   sizeof(VoxWordSlot)) ||
+        !section_ok(h, h.disp_off,    h.bucket_count, sizeof(uint32_t)) ||
+        !section_ok(h, h.leadins_off, h.leadin_count, sizeof(VoxPhrase)) ||
+        !section_ok(h, h.pool_off,    h.pool_units,   sizeof(uint16_t)) ||
+        h.name_off < sizeof(NtrpHeader) || h.name_off >= size || h.name_len >= size - h.name_off ||
+        p[h.name_off + h.name_len] != '\0'){
+        err = "corrupt rule pack"; return false;
+    }
+    const VoxWordSlot* slots   = (const VoxWordSlot*)(p + h.slots_off);
+    const VoxPhrase*   leadins = (const VoxPhrase*)(p + h.leadins_off);
+    for (uint32_t i = 0; i < h.slot_count; ++i)
+        if ((uint64_t)slots[i].off + slots[i].len > h.pool_units){ err = "corrupt word table"; return false; }
+    for (uint32_t i = 0; i < h.leadin_count; ++i)
+        if ((uint64_t)leadins[i].off + leadins[i].len > h.pool_units){ err = "corrupt lead-in table"; return false; }
+    if (h.max_beats < 2){ err = "corrupt break policy"; return false; }
+
+    R.name            = p + h.name_off;
+    R.slots           = slots;
+    R.slot_count      = h.slot_count;
+    R.disp            = (const uint32_t*)(p + h.disp_off);
+    R.bucket_count    = h.bucket_count;
+    R.pool            = (const uint16_t*)(p + h.pool_off);
+    R.leadins         = leadins;
+    R.leadin_count    = h.leadin_count;
+    R.pause_cs        = h.pause_cs;
+    R.max_beats       = h.max_beats;
+    R.heavy_syllables = h.heavy_syllables;
+    R.heavy_chars     = h.heavy_chars;
+    R.flags           = h.flags;
+    return true;
+}
+
+// A registered pack that owns its file mapping
+struct MappedPack : VoxRulePack {
+    HANDLE      file = INVALID_HANDLE_VALUE;
+    HANDLE      map  = nullptr;
+    const void* view = nullptr;
+    ~MappedPack(){
+        if (view) UnmapViewOfFile(view);
+        if (map) CloseHandle(map);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+    }
+};
+
+// ---- registry ----
+// The pack list is only touched under g_packs_cs (pointer copies, never file I/O); the
+// default is a separate atomic shared_ptr so the per-message path doesn't take the lock.
+CRITICAL_SECTION        g_packs_cs;
+std::atomic<bool>       g_packs_init{false};
+std::vector<VoxPackRef> g_packs;
+VoxPackRef              g_default;
+std::atomic<uint32_t>   g_next_id{1};
+
+void packs_init(){
+    if (g_packs_init.load(std::memory_order_acquire)) return;
+    static LONG once = 0;
+    if (InterlockedCompareExchange(&once, 1, 0) == 0){
+        InitializeCriticalSection(&g_packs_cs);
+        auto b = std::make_shared<VoxRulePack>();
+        b->name  = "builtin";
+        b->id    = 0;
+        b->rules = vox_builtin_rules();
+        g_packs.push_back(b);
+        std::atomic_store(&g_default, VoxPackRef(b));
+        g_packs_init.store(true, std::memory_order_release);
+    } else {
+        while (!g_packs_init.load(std::memory_order_acquire)) Sleep(0);
+    }
+}
+
+std::wstring win_error(const wchar_t* what, const std::wstring& path){
+    wchar_t buf[64]; _snwprintf(buf, 63, L" (error %lu)", GetLastError()); buf[63] = 0;
+    return std::wstring(what) + L" " + path + buf;
+}
+
+} // namespace
+
+bool vox_rulepack_compile_file(const std::wstring& src_path, const std::wstring& out_path, std::wstring& err){
+    HANDLE h = CreateFileW(src_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE){ err = win_error(L"cannot read", src_path); return false; }
+    std::string text;
+    char buf[16384]; DWORD rd = 0;
+    while (ReadFile(h, buf, sizeof(buf), &rd, nullptr) && rd > 0) text.append(buf, rd);
+    CloseHandle(h);
+    if (text.compare(0, 3, "\xEF\xBB\xBF") == 0) text.erase(0, 3);
+
+    PackSource ps; std::string blob, e;
+    if (!parse_source(text, ps, e) || !build_blob(ps, blob, e)){
+        err = src_path + L": " + u8_to_w(e);
+        return false;
+    }
+    h = CreateFileW(out_path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (h == INVALID_HANDLE_VALUE){ err = win_error(L"cannot write", out_path); return false; }
+    DWORD wr = 0;
+    bool ok = WriteFile(h, blob.data(), (DWORD)blob.size(), &wr, nullptr) && wr == blob.size();
+    CloseHandle(h);
+    if (!ok) err = win_error(L"write failed on", out_path);
+    return ok;
+}
+
+bool vox_rulepack_load(const std::wstring& path, std::string& name, std::wstring& err){
+    packs_init();
+    auto pk = std::make_shared<MappedPack>();
+    // FILE_SHARE_DELETE lets the pack file be replaced (renamed over) while it is mapped
+    pk->file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (pk->file == INVALID_HANDLE_VALUE){ err = win_error(L"cannot open", path); return false; }
+    LARGE_INTEGER sz{};
+    if (!GetFileSizeEx(pk->file, &sz) || sz.QuadPart < (LONGLONG)sizeof(NtrpHeader) || sz.QuadPart > 0x7FFFFFFF){
+        err = path + L": not a compiled rule pack"; return false;
+    }
+    pk->map = CreateFileMappingW(pk->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (pk->map) pk->view = MapViewOfFile(pk->map, FILE_MAP_READ, 0, 0, 0);
+    if (!pk->view){ err = win_error(L"cannot map", path); return false; }
+
+    std::string e;
+    if (!view_pack(pk->view, (size_t)sz.QuadPart, pk->rules, e)){ err = path + L": " + u8_to_w(e); return false; }
+    pk->name = pk->rules.name;
+    pk->id   = g_next_id.fetch_add(1);
+    name = pk->name;
+    if (name == "builtin"){ err = path + L": the name \"builtin\" is reserved"; return false; }
+
+    VoxPackRef ref(pk);
+    EnterCriticalSection(&g_packs_cs);
+    bool replaced = false;
+    for (VoxPackRef& p : g_packs) if (p->name == name){ p = ref; replaced = true; }
+    if (!replaced) g_packs.push_back(ref);
+    VoxPackRef cur = std::atomic_load(&g_default);
+    if (cur && cur->name == name) std::atomic_store(&g_default, ref);
+    LeaveCriticalSection(&g_packs_cs);
+    return true;
+}
+
+bool vox_rulepack_select(const std::string& name){
+    packs_init();
+    bool found = false;
+    EnterCriticalSection(&g_packs_cs);
+    for (const VoxPackRef& p : g_packs) if (p->name == name){ std::atomic_store(&g_default, p); found = true; break; }
+    LeaveCriticalSection(&g_packs_cs);
+    return found;
+}
+
+VoxPackRef vox_rulepack_get(const std::string& name){
+    packs_init();
+    if (name.empty()) return std::atomic_load(&g_default);
+    VoxPackRef found;
+    EnterCriticalSection(&g_packs_cs);
+    for (const VoxPackRef& p : g_packs) if (p->name == name){ found = p; break; }
+    LeaveCriticalSection(&g_packs_cs);
+    return found;
+}
+
+std::string vox_rulepack_list(){
+    packs_init();
+    VoxPackRef cur = std::atomic_load(&g_default);
+    std::string out;
+    EnterCriticalSection(&g_packs_cs);
+    for (const VoxPackRef& p : g_packs){
+        if (!out.empty()) out += ' ';
+        out += p->name;
+        if (p == cur) out += '*';
+    }
+    LeaveCriticalSection(&g_packs_cs);
+    return out;
+}
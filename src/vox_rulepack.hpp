@@ -0,0 +1,30 @@
+#pragma once
+#include "vox_rules.hpp"
+#include <memory>
+#include <string>
+
+// Rule packs: VOX word lists, lead-ins and break policy compiled into a binary "NTRP" file
+// (--compile-rulepack), memory-mapped at load and used in place by the encoder.
+//
+// Packs live in a small registry keyed by name; "builtin" (the compiled-in rules) is always
+// there. Loading a pack whose name is already registered replaces it atomically: encoders
+// take a VoxPackRef for the message they are working on, so a swap never waits for them and
+// the old mapping goes away when the last message using it is done.
+struct VoxRulePack {
+    std::string name;
+    uint32_t    id = 0;    // unique per load (0 = builtin); part of the VOX cache key
+    VoxRules    rules{};
+};
+typedef std::shared_ptr<const VoxRulePack> VoxPackRef;
+
+// Rule-pack source (text, see docs/rulepacks.md) -> compiled pack file.
+bool vox_rulepack_compile_file(const std::wstring& src_path, const std::wstring& out_path, std::wstring& err);
+
+// Maps a compiled pack and registers it under its own name; `name` receives that name.
+bool vox_rulepack_load(const std::wstring& path, std::string& name, std::wstring& err);
+// Makes a registered pack the default for messages that don't pick one.
+bool vox_rulepack_select(const std::string& name);
+// Empty name = the current default; null if no pack has that name.
+VoxPackRef vox_rulepack_get(const std::string& name);
+// "builtin pa* narrator" (* marks the default)
+std::string vox_rulepack_list();
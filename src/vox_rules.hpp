@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Everything the VOX encoder looks up instead of hard-coding: word classes, lead-in phrases
+// and the break policy. The built-in rules (vox_builtin_rules()) and compiled rule packs
+// (vox_rulepack.cpp, "NTRP" files) share this layout, so a memory-mapped pack is used in place.
+// Strings are lowercase UTF-16 code units in `pool`; all offsets are in units, not bytes.
+
+// Word classes a token can belong to (bitmask in Tok::cls)
+enum WordClass : uint16_t {
+    WC_THE        = 1u << 0,   // "the" (thee rule)
+    WC_AND        = 1u << 1,
+    WC_IS         = 1u << 2,
+    WC_THEE_PREP  = 1u << 3,   // prepositions that turn a following "the" into "thee"
+    WC_STOP       = 1u << 4,   // weight(): LIGHT
+    WC_LIGHTVERB  = 1u << 5,   // weight(): LIGHT
+    WC_UNIT       = 1u << 6,   // weight(): HEAVY
+    WC_LINKER     = 1u << 7,   // build_beats(): isolated between breaks
+    WC_DETERMINER = 1u << 8,   // build_beats(): pre-copula trigger
+    WC_AREA       = 1u << 9,   // area heads (lowercased; build_beats() checks the exact case)
+    WC_COUNT      = 10
+};
+
+// Rule switches (VoxRules::flags)
+enum VoxRuleFlag : uint16_t {
+    VR_THEE    = 1u << 0,   // "the" -> "thee"
+    VR_LEADIN  = 1u << 1,   // break after lead-in phrases
+    VR_NUMBERS = 1u << 2,   // time / number / degree rewrites
+    VR_LINKERS = 1u << 3,   // [BR] linker [BR]
+    VR_COPULA  = 1u << 4,   // break before "is" + determiner/content
+    VR_ALL     = 0x1F
+};
+
+struct VoxWordSlot { uint32_t off; uint16_t len; uint16_t cls; uint32_t hash; };   // len 0 = empty
+struct VoxPhrase   { uint32_t off; uint32_t len; };
+
+struct VoxRules {
+    const char*        name;
+    // word classes: hash-and-displace perfect hash (see vox_word_bucket / vox_word_slot)
+    const VoxWordSlot* slots;
+    uint32_t           slot_count;     // power of two
+    const uint32_t*    disp;
+    uint32_t           bucket_count;   // power of two
+    const uint16_t*    pool;
+    // lead-in phrases, tried in order; words separated by single spaces
+    const VoxPhrase*   leadins;
+    uint32_t           leadin_count;
+    // break policy
+    uint16_t           pause_cs;         // sentence-end pause (\!sfN)
+    uint8_t            max_beats;        // content beats before a forced break (>= 2)
+    uint8_t            heavy_syllables;  // a word this many syllables or more is HEAVY
+    uint8_t            heavy_chars;      // ... or this many chars or more
+    uint16_t           flags;            // VoxRuleFlag bits
+};
+
+const VoxRules& vox_builtin_rules();
+const char* vox_word_class_name(int bit);   // "the", "stop", ... (rule-pack section names)
+
+// ---- hashing shared by the built-in table and the rule-pack compiler ----
+static constexpr uint32_t kVoxFnvBasis = 2166136261u;
+static constexpr uint32_t kVoxFnvPrime = 16777619u;
+
+static constexpr uint32_t vox_word_mix(uint32_t h, uint32_t d){
+    h ^= d * 0x9E3779B9u;
+    h ^= h >> 16; h *= 0x85EBCA6Bu;
+    h ^= h >> 13; h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+static constexpr uint32_t vox_word_bucket(uint32_t h, uint32_t buckets){ return vox_word_mix(h, 0) & (buckets-1); }
+static constexpr uint32_t vox_word_slot(uint32_t h, uint32_t d, uint32_t slots){ return vox_word_mix(h, d) & (slots-1); }
+static constexpr uint32_t vox_pow2_at_least(uint32_t n){ uint32_t p = 1; while(p<n) p <<= 1; return p; }
+
+// Table sizes for n words: load factor <= 1/2, about four words per bucket.
+static constexpr uint32_t vox_slots_for(uint32_t n){ return vox_pow2_at_least(2*n); }
+static constexpr uint32_t vox_buckets_for(uint32_t n){ return vox_pow2_at_least(n/4 + 1); }
+
+// Hash-and-displace placement of n distinct hashes: fills disp[bucket] and slot_of[word] so no
+// two words share a slot. Fullest buckets go first; each searches the first displacement whose
+// slots are all free. `used` must hold `slots` falses; `order` is scratch for n word indices,
+// which a counting sort groups by bucket, largest buckets first, so placement is one pass over
+// the words. Works at compile time and at runtime.
+template<class Hashes, class Disp, class SlotOf, class Used, class Order>
+constexpr bool vox_place_words(const Hashes& hash, uint32_t n, Disp& disp, uint32_t buckets,
+                               SlotOf& slot_of, Used& used, uint32_t slots, Order& order){
+    constexpr uint32_t kMaxBucket = 32;
+    constexpr uint32_t kMaxDisp   = 1u << 20;
+    // disp[] holds each bucket's size, then its next position in order[], then its displacement
+    for(uint32_t b=0;b<buckets;++b) disp[b] = 0;
+    for(uint32_t k=0;k<n;++k) if(++disp[vox_word_bucket(hash[k], buckets)]>kMaxBucket) return false;
+    uint32_t at[kMaxBucket+1] = {};   // first position of the buckets of each size
+    for(uint32_t b=0;b<buckets;++b) at[disp[b]] += disp[b];
+    for(uint32_t size=kMaxBucket, pos=0; size>0; --size){ const uint32_t words = at[size]; at[size] = pos; pos += words; }
+    for(uint32_t b=0;b<buckets;++b){ const uint32_t size = disp[b]; disp[b] = at[size]; at[size] += size; }
+    for(uint32_t k=0;k<n;++k) order[disp[vox_word_bucket(hash[k], buckets)]++] = k;
+
+    for(uint32_t i=0;i<n;){
+        const uint32_t b = vox_word_bucket(hash[order[i]], buckets);
+        uint32_t e = i+1;
+        while(e<n && vox_word_bucket(hash[order[e]], buckets)==b) ++e;
+        uint32_t d = 1;
+        for(; d<kMaxDisp; ++d){
+            uint32_t taken[kMaxBucket] = {};
+            uint32_t nt = 0;
+            bool fits = true;
+            for(uint32_t j=i;j<e && fits;++j){
+                uint32_t s = vox_word_slot(hash[order[j]], d, slots);
+                if(used[s]) fits = false;
+                for(uint32_t q=0;q<nt && fits;++q) if(taken[q]==s) fits = false;
+                taken[nt++] = s;
+            }
+            if(fits) break;
+        }
+        if(d==kMaxDisp) return false;
+        disp[b] = d;
+        for(uint32_t j=i;j<e;++j){
+            slot_of[order[j]] = vox_word_slot(hash[order[j]], d, slots);
+            used[slot_of[order[j]]] = true;
+        }
+        i = e;
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+
+// Per-stage counters inside the VOX encoder. On by default; build with
+// -DNETTTS_VOX_STATS=0 (make VOX_STATS=0) to compile them out, which leaves only the hook check.
+#ifndef NETTTS_VOX_STATS
+#define NETTTS_VOX_STATS 1
+#endif
+
+// Stage boundaries inside the VOX encoder, for profiling tools (bench/vox_bench.cpp) and the
+// built-in counters below.
+enum VoxStage {
+    VOX_STAGE_SPLIT,      // split_sentences
+    VOX_STAGE_TOKENIZE,   // sentence -> token array
+    VOX_STAGE_THEE,       // apply_thee_rule
+    VOX_STAGE_LEADIN,     // apply_leadin_break
+    VOX_STAGE_NUMBERS,    // apply_time_numbers_degrees
+    VOX_STAGE_BEATS,      // build_beats
+    VOX_STAGE_LETTERS,    // normalize_letter_tokens
+    VOX_STAGE_TIDY,       // tidy (token array -> text)
+    VOX_STAGE_FINISH,     // join fixups + wrap
+    VOX_STAGE_COUNT
+};
+
+const char* vox_stage_name(int stage);
+
+// Called at the start (end==false) and end (end==true) of every stage, on the encoding
+// thread. Install before encoding starts; it is not synchronized.
+typedef void (*VoxStageHook)(void* user, int stage, bool end);
+void vox_set_stage_hook(VoxStageHook hook, void* user);
+
+// ---- Built-in counters ----
+// Every stage call adds its duration (TSC ticks on x86, else ns) and its text size before and
+// after, in UTF-16 units (token stages count the tokens' text plus one space between each).
+// Each encoding thread writes its own block, so counting takes no locks; readers sum them.
+enum { VOX_STAGE_HIST = 32 };
+struct VoxStageStats {
+    uint64_t calls;
+    uint64_t ticks;
+    uint64_t ticks_max;
+    uint64_t units_in;
+    uint64_t units_out;
+    uint64_t growth_max;              // largest single-call out/in ratio, in 1/1000
+    uint64_t hist[VOX_STAGE_HIST];    // calls taking [2^k, 2^(k+1)) ticks (bucket 0 also holds 0)
+};
+
+// One entry per stage, summed over all threads since start or the last reset.
+// Returns false (and zeros) when the counters are compiled out.
+bool vox_stage_stats(VoxStageStats out[VOX_STAGE_COUNT]);
+void vox_stage_stats_reset();
+const char* vox_stage_tick_unit();   // "cycles" or "ns"